@@ -8,16 +8,24 @@
 #include <dlfcn.h>
 #include <sys/system_properties.h>
 
+#include "SurfaceControlApi.hpp"
+
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <array>
+#include <chrono>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <functional>
+#include <mutex>
+#include <shared_mutex>
 
 #ifndef LOGTAG
 #define LOGTAG "ANwCreator"
@@ -65,20 +73,133 @@ namespace android::anwcreator::detail::types
         return (lhs = lhs | rhs);
     }
 
+    // Single-writer seqlock for small trivially copyable values. Readers never block and
+    // retry while a write is in progress. Writers must be serialized by the caller.
+    template <typename value_t>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable_v<value_t> && sizeof(value_t) % sizeof(uint32_t) == 0);
+        static constexpr size_t kWords = sizeof(value_t) / sizeof(uint32_t);
+
+    public:
+        void Store(const value_t &value)
+        {
+            uint32_t words[kWords];
+            memcpy(words, &value, sizeof(value_t));
+
+            uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+            m_sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < kWords; ++i)
+                m_words[i].store(words[i], std::memory_order_relaxed);
+            m_sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        value_t Load() const
+        {
+            uint32_t words[kWords];
+            uint32_t before, after;
+            do
+            {
+                before = m_sequence.load(std::memory_order_acquire);
+                for (size_t i = 0; i < kWords; ++i)
+                    words[i] = m_words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = m_sequence.load(std::memory_order_relaxed);
+            } while (before != after || (before & 1));
+
+            value_t value;
+            memcpy(&value, words, sizeof(value_t));
+            return value;
+        }
+
+    private:
+        std::atomic<uint32_t> m_sequence{0};
+        std::atomic<uint32_t> m_words[kWords]{};
+    };
+
 } // namespace android::anwcreator::detail::types
 
 namespace android::anwcreator::detail::jni
 {
 
+    // The calling thread's JNIEnv, attached on first use and cached per thread. A thread
+    // attached here is detached again when it exits, which ART requires before a thread
+    // ends. Threads that were already attached (e.g. the activity's main thread) are left
+    // alone.
+    class ThreadEnv
+    {
+    public:
+        static JNIEnv *Get(JavaVM *vm)
+        {
+            thread_local ThreadEnv state;
+            if (vm == state.m_vm && state.m_env)
+                return state.m_env;
+
+            if (!vm)
+                return nullptr;
+
+            state.Detach();
+
+            JNIEnv *env = nullptr;
+            jint status = vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
+            if (JNI_EDETACHED == status)
+            {
+                JavaVMAttachArgs args{JNI_VERSION_1_6, "ANwCreator", nullptr};
+                if (JNI_OK != vm->AttachCurrentThread(&env, &args))
+                    return nullptr;
+                state.m_attached = true;
+            }
+            else if (JNI_OK != status)
+            {
+                return nullptr;
+            }
+
+            state.m_vm = vm;
+            state.m_env = env;
+            return env;
+        }
+
+        ~ThreadEnv()
+        {
+            Detach();
+        }
+
+    private:
+        void Detach()
+        {
+            if (m_attached && m_vm)
+                m_vm->DetachCurrentThread();
+            m_vm = nullptr;
+            m_env = nullptr;
+            m_attached = false;
+        }
+
+        JavaVM *m_vm = nullptr;
+        JNIEnv *m_env = nullptr;
+        bool m_attached = false;
+    };
+
+    // Describes and clears a pending exception. Returns true when there was one.
+    inline bool CheckException(JNIEnv *env, const char *context = nullptr)
+    {
+        if (!env || !env->ExceptionCheck())
+            return false;
+
+        if (context)
+            LogError("JNI exception in %s", context);
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+        return true;
+    }
+
     struct JNIEnvironment
     {
         JNIEnv *env;
         JavaVM *vm;
 
-        JNIEnvironment(JavaVM *javaVM) : vm(javaVM), env(nullptr)
+        JNIEnvironment(JavaVM *javaVM) : env(ThreadEnv::Get(javaVM)), vm(javaVM)
         {
-            if (vm)
-                vm->AttachCurrentThread(&env, nullptr);
         }
 
         ~JNIEnvironment() {}
@@ -100,13 +221,36 @@ namespace android::anwcreator::detail::jni
 
         inline bool CheckException(const char *context = nullptr)
         {
-            if (!env || !env->ExceptionCheck())
-                return false;
+            return jni::CheckException(env, context);
+        }
+    };
 
-            env->ExceptionDescribe();
-            env->ExceptionClear();
-            return true;
+    // Frees every local ref created while it is alive, in one PopLocalFrame. Threads
+    // attached from native code never return to Java, so their local refs would
+    // otherwise only go away when they are deleted one by one.
+    struct LocalFrame
+    {
+        JNIEnv *env;
+        bool pushed;
+
+        LocalFrame(JNIEnv *e, jint capacity = 16) : env(e), pushed(false)
+        {
+            if (!env)
+                return;
+
+            pushed = JNI_OK == env->PushLocalFrame(capacity);
+            if (!pushed)
+                env->ExceptionClear(); // OutOfMemoryError, refs then live in the enclosing frame
         }
+
+        ~LocalFrame()
+        {
+            if (pushed)
+                env->PopLocalFrame(nullptr);
+        }
+
+        LocalFrame(const LocalFrame &) = delete;
+        LocalFrame &operator=(const LocalFrame &) = delete;
     };
 
     struct LocalRef
@@ -138,14 +282,16 @@ namespace android::anwcreator::detail::jni
         inline explicit operator bool() const { return obj != nullptr; }
     };
 
+    // Global refs outlive the thread that made them, so the release goes through the
+    // releasing thread's own JNIEnv.
     struct GlobalRef
     {
-        JNIEnv *env;
+        JavaVM *vm;
         jobject obj;
 
-        GlobalRef(JNIEnv *e, jobject o) : env(e), obj(nullptr)
+        GlobalRef(JNIEnv *e, jobject o) : vm(nullptr), obj(nullptr)
         {
-            if (e && o)
+            if (e && o && JNI_OK == e->GetJavaVM(&vm))
                 obj = e->NewGlobalRef(o);
         }
 
@@ -156,17 +302,18 @@ namespace android::anwcreator::detail::jni
 
         void Release()
         {
-            if (env && obj)
-            {
+            if (!obj)
+                return;
+
+            if (JNIEnv *env = ThreadEnv::Get(vm))
                 env->DeleteGlobalRef(obj);
-                obj = nullptr;
-            }
+            obj = nullptr;
         }
 
         GlobalRef(const GlobalRef &) = delete;
         GlobalRef &operator=(const GlobalRef &) = delete;
 
-        GlobalRef(GlobalRef &&other) noexcept : env(other.env), obj(other.obj)
+        GlobalRef(GlobalRef &&other) noexcept : vm(other.vm), obj(other.obj)
         {
             other.obj = nullptr;
         }
@@ -177,6 +324,200 @@ namespace android::anwcreator::detail::jni
         inline explicit operator bool() const { return obj != nullptr; }
     };
 
+    // Classes and member IDs used by the framework wrappers, resolved once per JavaVM in
+    // a single batch on first use. Classes are held as global refs, so the IDs stay valid.
+    // Members missing on this release (hidden or newer APIs) are left null.
+    struct ClassCache
+    {
+        jclass activity = nullptr;
+        jclass windowManager = nullptr;
+        jclass display = nullptr;
+        jclass displayMetrics = nullptr;
+        jclass window = nullptr;
+        jclass view = nullptr;
+        jclass viewRootImpl = nullptr;
+        jclass builder = nullptr;
+        jclass transaction = nullptr;
+        jclass surface = nullptr;
+        jclass rect = nullptr;
+
+        jmethodID activityGetWindowManager = nullptr;
+        jmethodID activityGetWindow = nullptr;
+        jmethodID windowManagerGetDefaultDisplay = nullptr;
+        jmethodID displayGetRealMetrics = nullptr;
+        jmethodID displayGetRotation = nullptr;
+        jmethodID displayGetRefreshRate = nullptr;
+        jmethodID displayMetricsCtor = nullptr;
+        jfieldID displayMetricsWidthPixels = nullptr;
+        jfieldID displayMetricsHeightPixels = nullptr;
+        jfieldID displayMetricsDensity = nullptr;
+        jfieldID displayMetricsDensityDpi = nullptr;
+        jmethodID windowGetDecorView = nullptr;
+        jmethodID viewGetViewRootImpl = nullptr;
+        jmethodID viewRootImplGetSurfaceControl = nullptr;
+
+        jmethodID builderCtor = nullptr;
+        jmethodID builderSetName = nullptr;
+        jmethodID builderSetParent = nullptr;
+        jmethodID builderSetBufferSize = nullptr;
+        jmethodID builderSetFlags = nullptr;
+        jmethodID builderBuild = nullptr;
+
+        jmethodID transactionCtor = nullptr;
+        jmethodID transactionSetAlpha = nullptr;
+        jmethodID transactionSetLayer = nullptr;
+        jmethodID transactionSetPosition = nullptr;
+        jmethodID transactionSetBufferSize = nullptr;
+        jmethodID transactionSetScale = nullptr;
+        jmethodID transactionSetMatrix = nullptr;
+        jmethodID transactionSetCrop = nullptr;
+        jmethodID transactionSetFrameRate = nullptr;
+        jmethodID transactionSetOpaque = nullptr;
+        jmethodID transactionShow = nullptr;
+        jmethodID transactionHide = nullptr;
+        jmethodID transactionRemove = nullptr;
+        jmethodID transactionApply = nullptr;
+        jmethodID transactionSync = nullptr; // static
+
+        jmethodID surfaceCtor = nullptr;
+        jmethodID rectCtor = nullptr;
+
+        // Returns null when env is null or the VM cannot be queried.
+        static const ClassCache *Get(JNIEnv *env)
+        {
+            // One JNIEnv per thread and VM, so the last answer is good as long as env matches.
+            thread_local JNIEnv *lastEnv = nullptr;
+            thread_local const ClassCache *lastCache = nullptr;
+            if (env && env == lastEnv)
+                return lastCache;
+
+            JavaVM *vm = nullptr;
+            if (!env || JNI_OK != env->GetJavaVM(&vm))
+                return nullptr;
+
+            static std::mutex mutex;
+            static std::unordered_map<JavaVM *, std::unique_ptr<ClassCache>> caches;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &cache = caches[vm];
+            if (!cache)
+            {
+                cache = std::make_unique<ClassCache>();
+                cache->Resolve(env);
+            }
+
+            lastEnv = env;
+            lastCache = cache.get();
+            return lastCache;
+        }
+
+    private:
+        void Resolve(JNIEnv *env)
+        {
+            constexpr const char *kBuilder = "Landroid/view/SurfaceControl$Builder;";
+            constexpr const char *kTransaction = "Landroid/view/SurfaceControl$Transaction;";
+
+            activity = FindClass(env, "android/app/Activity");
+            windowManager = FindClass(env, "android/view/WindowManager");
+            display = FindClass(env, "android/view/Display");
+            displayMetrics = FindClass(env, "android/util/DisplayMetrics");
+            window = FindClass(env, "android/view/Window");
+            view = FindClass(env, "android/view/View");
+            viewRootImpl = FindClass(env, "android/view/ViewRootImpl");
+            builder = FindClass(env, "android/view/SurfaceControl$Builder");
+            transaction = FindClass(env, "android/view/SurfaceControl$Transaction");
+            surface = FindClass(env, "android/view/Surface");
+            rect = FindClass(env, "android/graphics/Rect");
+
+            activityGetWindowManager = GetMethod(env, activity, "getWindowManager", "()Landroid/view/WindowManager;");
+            activityGetWindow = GetMethod(env, activity, "getWindow", "()Landroid/view/Window;");
+            windowManagerGetDefaultDisplay = GetMethod(env, windowManager, "getDefaultDisplay", "()Landroid/view/Display;");
+            displayGetRealMetrics = GetMethod(env, display, "getRealMetrics", "(Landroid/util/DisplayMetrics;)V");
+            displayGetRotation = GetMethod(env, display, "getRotation", "()I");
+            displayGetRefreshRate = GetMethod(env, display, "getRefreshRate", "()F");
+            displayMetricsCtor = GetMethod(env, displayMetrics, "<init>", "()V");
+            displayMetricsWidthPixels = GetField(env, displayMetrics, "widthPixels", "I");
+            displayMetricsHeightPixels = GetField(env, displayMetrics, "heightPixels", "I");
+            displayMetricsDensity = GetField(env, displayMetrics, "density", "F");
+            displayMetricsDensityDpi = GetField(env, displayMetrics, "densityDpi", "I");
+            windowGetDecorView = GetMethod(env, window, "getDecorView", "()Landroid/view/View;");
+            viewGetViewRootImpl = GetMethod(env, view, "getViewRootImpl", "()Landroid/view/ViewRootImpl;");
+            viewRootImplGetSurfaceControl = GetMethod(env, viewRootImpl, "getSurfaceControl", "()Landroid/view/SurfaceControl;");
+
+            std::string sig;
+            builderCtor = GetMethod(env, builder, "<init>", "()V");
+            builderSetName = GetMethod(env, builder, "setName", (sig = "(Ljava/lang/String;)").append(kBuilder).c_str());
+            builderSetParent = GetMethod(env, builder, "setParent", (sig = "(Landroid/view/SurfaceControl;)").append(kBuilder).c_str());
+            builderSetBufferSize = GetMethod(env, builder, "setBufferSize", (sig = "(II)").append(kBuilder).c_str());
+            builderSetFlags = GetMethod(env, builder, "setFlags", (sig = "(II)").append(kBuilder).c_str());
+            builderBuild = GetMethod(env, builder, "build", "()Landroid/view/SurfaceControl;");
+
+            transactionCtor = GetMethod(env, transaction, "<init>", "()V");
+            transactionSetAlpha = GetMethod(env, transaction, "setAlpha", (sig = "(Landroid/view/SurfaceControl;F)").append(kTransaction).c_str());
+            transactionSetLayer = GetMethod(env, transaction, "setLayer", (sig = "(Landroid/view/SurfaceControl;I)").append(kTransaction).c_str());
+            transactionSetPosition = GetMethod(env, transaction, "setPosition", (sig = "(Landroid/view/SurfaceControl;FF)").append(kTransaction).c_str());
+            transactionSetBufferSize = GetMethod(env, transaction, "setBufferSize", (sig = "(Landroid/view/SurfaceControl;II)").append(kTransaction).c_str());
+            transactionSetScale = GetMethod(env, transaction, "setScale", (sig = "(Landroid/view/SurfaceControl;FF)").append(kTransaction).c_str());
+            transactionSetMatrix = GetMethod(env, transaction, "setMatrix", (sig = "(Landroid/view/SurfaceControl;FFFF)").append(kTransaction).c_str());
+            transactionSetCrop = GetMethod(env, transaction, "setCrop", (sig = "(Landroid/view/SurfaceControl;Landroid/graphics/Rect;)").append(kTransaction).c_str());
+            transactionSetFrameRate = GetMethod(env, transaction, "setFrameRate", (sig = "(Landroid/view/SurfaceControl;FI)").append(kTransaction).c_str());
+            transactionSetOpaque = GetMethod(env, transaction, "setOpaque", (sig = "(Landroid/view/SurfaceControl;Z)").append(kTransaction).c_str());
+            transactionShow = GetMethod(env, transaction, "show", (sig = "(Landroid/view/SurfaceControl;)").append(kTransaction).c_str());
+            transactionHide = GetMethod(env, transaction, "hide", (sig = "(Landroid/view/SurfaceControl;)").append(kTransaction).c_str());
+            transactionRemove = GetMethod(env, transaction, "remove", (sig = "(Landroid/view/SurfaceControl;)").append(kTransaction).c_str());
+            transactionApply = GetMethod(env, transaction, "apply", "()V");
+            if (transaction)
+            {
+                transactionSync = env->GetStaticMethodID(transaction, "sync", "()V");
+                ClearException(env);
+            }
+
+            surfaceCtor = GetMethod(env, surface, "<init>", "(Landroid/view/SurfaceControl;)V");
+            rectCtor = GetMethod(env, rect, "<init>", "(IIII)V");
+        }
+
+        static jclass FindClass(JNIEnv *env, const char *name)
+        {
+            jclass local = env->FindClass(name);
+            if (!local)
+            {
+                ClearException(env);
+                return nullptr;
+            }
+
+            auto global = reinterpret_cast<jclass>(env->NewGlobalRef(local));
+            env->DeleteLocalRef(local);
+            return global;
+        }
+
+        static jmethodID GetMethod(JNIEnv *env, jclass cls, const char *name, const char *sig)
+        {
+            if (!cls)
+                return nullptr;
+
+            jmethodID method = env->GetMethodID(cls, name, sig);
+            ClearException(env);
+            return method;
+        }
+
+        static jfieldID GetField(JNIEnv *env, jclass cls, const char *name, const char *sig)
+        {
+            if (!cls)
+                return nullptr;
+
+            jfieldID field = env->GetFieldID(cls, name, sig);
+            ClearException(env);
+            return field;
+        }
+
+        // A failed lookup leaves NoSuchMethodError/ClassNotFoundException pending.
+        static void ClearException(JNIEnv *env)
+        {
+            if (env->ExceptionCheck())
+                env->ExceptionClear();
+        }
+    };
+
 } // namespace android::anwcreator::detail::jni
 
 namespace android::anwcreator::detail::framework
@@ -196,69 +537,169 @@ namespace android::anwcreator::detail::framework
         int32_t height;
         types::DisplayRotation rotation;
         float refreshRate;
+        float density;
+        int32_t densityDpi;
+        uint32_t generation; // bumped on every change
     };
 
-    class Display
+    // Keeps the state of the activity's display. Refresh() walks Activity -> WindowManager
+    // -> Display once and keeps the Display and a DisplayMetrics as global refs. Poll()
+    // then costs two JNI calls (rotation, refresh rate) and re-reads the metrics into the
+    // same DisplayMetrics only when the rotation changed, or every kMetricsPolls polls for
+    // size changes without one (foldables, multi-window). A DisplayManager.DisplayListener
+    // would need a Java class, which native code cannot define without shipping dex.
+    //
+    // Get() returns the last published state without JNI calls or locks, from any thread.
+    class DisplayMonitor
     {
-        public:
-        static DisplayInfo GetDisplayInfo(JNIEnv *env, ANativeActivity *activity)
-            {
-                DisplayInfo info{};
+    public:
+        static constexpr int32_t kMetricsPolls = 8;
 
+        bool Refresh(JNIEnv *env, ANativeActivity *activity)
+        {
             if (!env || !activity || !activity->clazz)
-                    return info;
+                return false;
 
-            jni::LocalRef activityCls(env, env->GetObjectClass(activity->clazz));
-            if (!activityCls)
-                    return info;
+            const jni::ClassCache *ids = jni::ClassCache::Get(env);
+            if (!ids || !ids->activityGetWindowManager || !ids->windowManagerGetDefaultDisplay ||
+                !ids->displayMetricsCtor || !ids->displayGetRealMetrics || !ids->displayGetRotation)
+                return false;
 
-            jmethodID getWindowManager = env->GetMethodID(activityCls, "getWindowManager", "()Landroid/view/WindowManager;");
-            if (!getWindowManager)
-                return info;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            jni::LocalFrame frame(env);
 
-            jni::LocalRef windowManager(env, env->CallObjectMethod(activity->clazz, getWindowManager));
-            if (!windowManager || jni::JNIEnvironment(activity->vm).CheckException("Activity.getWindowManager()"))
-            {
-                    return info;
-            }
+            jni::LocalRef windowManager(env, env->CallObjectMethod(activity->clazz, ids->activityGetWindowManager));
+            if (!windowManager || jni::CheckException(env, "Activity.getWindowManager()"))
+                return false;
 
-            jni::LocalRef windowManagerCls(env, env->GetObjectClass(windowManager));
-            jmethodID getDefaultDisplay = env->GetMethodID(windowManagerCls, "getDefaultDisplay", "()Landroid/view/Display;");
-            if (!getDefaultDisplay)
-                return info;
+            jni::LocalRef display(env, env->CallObjectMethod(windowManager, ids->windowManagerGetDefaultDisplay));
+            if (!display || jni::CheckException(env, "WindowManager.getDefaultDisplay()"))
+                return false;
 
-            jni::LocalRef display(env, env->CallObjectMethod(windowManager, getDefaultDisplay));
-            if (!display || jni::JNIEnvironment(activity->vm).CheckException("WindowManager.getDefaultDisplay()"))
-            {
-                    return info;
-            }
+            jni::LocalRef displayMetrics(env, env->NewObject(ids->displayMetrics, ids->displayMetricsCtor));
+            if (!displayMetrics || jni::CheckException(env, "new DisplayMetrics()"))
+                return false;
+
+            // Like the class cache these live as long as the process; only a new activity replaces them.
+            if (m_display)
+                env->DeleteGlobalRef(m_display);
+            if (m_displayMetrics)
+                env->DeleteGlobalRef(m_displayMetrics);
+            m_display = env->NewGlobalRef(display);
+            m_displayMetrics = env->NewGlobalRef(displayMetrics);
+
+            DisplayInfo info = m_state.Load();
+            if (!Read(env, ids, info, true))
+                return false;
 
-            jni::LocalRef displayMetricsCls(env, env->FindClass("android/util/DisplayMetrics"));
-            jmethodID displayMetricsCtor = env->GetMethodID(displayMetricsCls, "<init>", "()V");
-            jni::LocalRef displayMetrics(env, env->NewObject(displayMetricsCls, displayMetricsCtor));
+            Publish(info);
+            m_activity.store(activity, std::memory_order_release);
+            return true;
+        }
+
+        // Returns true when the state changed. Does nothing (false) when the last poll was
+        // less than minInterval ns before `now`, or another thread is polling right now.
+        bool Poll(JNIEnv *env, int64_t now, int64_t minInterval)
+        {
+            if (now - m_lastPoll.load(std::memory_order_relaxed) < minInterval)
+                return false;
+
+            std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+            if (!lock || !m_display || !env)
+                return false;
+            m_lastPoll.store(now, std::memory_order_relaxed);
 
-            jni::LocalRef displayCls(env, env->GetObjectClass(display));
-            jmethodID getRealMetrics = env->GetMethodID(displayCls, "getRealMetrics", "(Landroid/util/DisplayMetrics;)V");
-            env->CallVoidMethod(display, getRealMetrics, displayMetrics.get());
+            const jni::ClassCache *ids = jni::ClassCache::Get(env);
+            if (!ids)
+                return false;
+
+            // Only this thread writes while the lock is held.
+            DisplayInfo current = m_state.Load();
+            DisplayInfo polled = current;
+            bool metrics = ++m_polls % kMetricsPolls == 0;
+            if (!Read(env, ids, polled, metrics))
+                return false;
+            if (!metrics && polled.rotation != current.rotation && !Read(env, ids, polled, true))
+                return false;
+
+            if (polled.width == current.width && polled.height == current.height && polled.rotation == current.rotation &&
+                polled.refreshRate == current.refreshRate && polled.density == current.density && polled.densityDpi == current.densityDpi)
+                return false;
+
+            Publish(polled);
+            return true;
+        }
 
-            jfieldID widthPixelsField = env->GetFieldID(displayMetricsCls, "widthPixels", "I");
-            jfieldID heightPixelsField = env->GetFieldID(displayMetricsCls, "heightPixels", "I");
+        DisplayInfo Get() const { return m_state.Load(); }
 
-            info.width = env->GetIntField(displayMetrics, widthPixelsField);
-            info.height = env->GetIntField(displayMetrics, heightPixelsField);
+        bool IsValidFor(ANativeActivity *activity) const
+        {
+            return activity && m_activity.load(std::memory_order_acquire) == activity;
+        }
 
-            jmethodID getRotation = env->GetMethodID(displayCls, "getRotation", "()I");
-            int32_t rotation = env->CallIntMethod(display, getRotation);
+    private:
+        // Stops at the first exception, a value returned along with it is garbage. `info`
+        // may then be partly written, callers drop it.
+        bool Read(JNIEnv *env, const jni::ClassCache *ids, DisplayInfo &info, bool metrics)
+        {
+            const jint rotation = env->CallIntMethod(m_display, ids->displayGetRotation);
+            if (jni::CheckException(env, "Display.getRotation()"))
+                return false;
             info.rotation = static_cast<types::DisplayRotation>(rotation);
 
-            jmethodID getRefreshRate = env->GetMethodID(displayCls, "getRefreshRate", "()F");
-            if (getRefreshRate)
+            if (ids->displayGetRefreshRate)
             {
-                info.refreshRate = env->CallFloatMethod(display, getRefreshRate);
+                const jfloat refreshRate = env->CallFloatMethod(m_display, ids->displayGetRefreshRate);
+                if (jni::CheckException(env, "Display.getRefreshRate()"))
+                    return false;
+                info.refreshRate = refreshRate;
             }
 
-                return info;
+            if (!metrics)
+                return true;
+
+            env->CallVoidMethod(m_display, ids->displayGetRealMetrics, m_displayMetrics);
+            if (jni::CheckException(env, "Display.getRealMetrics()"))
+                return false;
+
+            const jint width = env->GetIntField(m_displayMetrics, ids->displayMetricsWidthPixels);
+            const jint height = env->GetIntField(m_displayMetrics, ids->displayMetricsHeightPixels);
+            if (jni::CheckException(env, "DisplayMetrics.widthPixels/heightPixels"))
+                return false;
+            info.width = width;
+            info.height = height;
+
+            if (ids->displayMetricsDensity)
+            {
+                const jfloat density = env->GetFloatField(m_displayMetrics, ids->displayMetricsDensity);
+                if (jni::CheckException(env, "DisplayMetrics.density"))
+                    return false;
+                info.density = density;
             }
+            if (ids->displayMetricsDensityDpi)
+            {
+                const jint densityDpi = env->GetIntField(m_displayMetrics, ids->displayMetricsDensityDpi);
+                if (jni::CheckException(env, "DisplayMetrics.densityDpi"))
+                    return false;
+                info.densityDpi = densityDpi;
+            }
+            return true;
+        }
+
+        void Publish(DisplayInfo info)
+        {
+            info.generation = m_state.Load().generation + 1;
+            m_state.Store(info);
+        }
+
+    private:
+        std::mutex m_mutex; // serializes Refresh/Poll, the only writers
+        jobject m_display = nullptr;
+        jobject m_displayMetrics = nullptr;
+        uint32_t m_polls = 0;
+        std::atomic<int64_t> m_lastPoll{0};
+        std::atomic<ANativeActivity *> m_activity{nullptr};
+        types::SeqLock<DisplayInfo> m_state;
     };
 
     class SurfaceControl
@@ -268,24 +709,20 @@ namespace android::anwcreator::detail::framework
         {
             JNIEnv *env;
             jobject builder;
-            jclass builderClass;
+            const jni::ClassCache *ids;
 
-            Builder(JNIEnv *e) : env(e), builder(nullptr), builderClass(nullptr)
+            Builder(JNIEnv *e) : env(e), builder(nullptr), ids(jni::ClassCache::Get(e))
             {
-                builderClass = env->FindClass("android/view/SurfaceControl$Builder");
-                if (!builderClass)
+                if (!ids || !ids->builderCtor)
                     return;
 
-                jmethodID ctor = env->GetMethodID(builderClass, "<init>", "()V");
-                builder = env->NewObject(builderClass, ctor);
+                builder = env->NewObject(ids->builder, ids->builderCtor);
             }
 
             ~Builder()
             {
                 if (env && builder)
                     env->DeleteLocalRef(builder);
-                if (env && builderClass)
-                    env->DeleteLocalRef(builderClass);
             }
 
             Builder &SetName(const char *name)
@@ -293,12 +730,10 @@ namespace android::anwcreator::detail::framework
                 if (!builder)
                     return *this;
 
-                jmethodID setName = env->GetMethodID(builderClass, "setName",
-                                                     "(Ljava/lang/String;)Landroid/view/SurfaceControl$Builder;");
-                if (setName)
+                if (ids->builderSetName)
                 {
                     jni::LocalRef jName(env, env->NewStringUTF(name));
-                    builder = env->CallObjectMethod(builder, setName, jName.get());
+                    Call(ids->builderSetName, jName.get());
                 }
                 return *this;
             }
@@ -308,11 +743,9 @@ namespace android::anwcreator::detail::framework
                 if (!builder || !parent)
                     return *this;
 
-                jmethodID setParent = env->GetMethodID(builderClass, "setParent",
-                                                       "(Landroid/view/SurfaceControl;)Landroid/view/SurfaceControl$Builder;");
-                if (setParent)
+                if (ids->builderSetParent)
                 {
-                    builder = env->CallObjectMethod(builder, setParent, parent);
+                    Call(ids->builderSetParent, parent);
                 }
                 return *this;
             }
@@ -322,11 +755,9 @@ namespace android::anwcreator::detail::framework
                 if (!builder)
                     return *this;
 
-                jmethodID setBufferSize = env->GetMethodID(builderClass, "setBufferSize",
-                                                           "(II)Landroid/view/SurfaceControl$Builder;");
-                if (setBufferSize)
+                if (ids->builderSetBufferSize)
                 {
-                    builder = env->CallObjectMethod(builder, setBufferSize, width, height);
+                    Call(ids->builderSetBufferSize, width, height);
                 }
                 return *this;
             }
@@ -336,13 +767,9 @@ namespace android::anwcreator::detail::framework
                 if (!builder)
                     return *this;
 
-                jmethodID setFlags = env->GetMethodID(builderClass, "setFlags",
-                                                      "(II)Landroid/view/SurfaceControl$Builder;");
-                if (setFlags)
+                if (ids->builderSetFlags)
                 {
-                    builder = env->CallObjectMethod(builder, setFlags,
-                                                     static_cast<jint>(flags),
-                                                     static_cast<jint>(mask));
+                    Call(ids->builderSetFlags, static_cast<jint>(flags), static_cast<jint>(mask));
                 }
                 return *this;
             }
@@ -359,127 +786,180 @@ namespace android::anwcreator::detail::framework
 
             jobject Build()
             {
-                if (!builder)
+                if (!builder || !ids->builderBuild)
                     return nullptr;
 
-                jmethodID buildMethod = env->GetMethodID(builderClass, "build", "()Landroid/view/SurfaceControl;");
-                if (!buildMethod)
-                    return nullptr;
-
-                return env->CallObjectMethod(builder, buildMethod);
+                return env->CallObjectMethod(builder, ids->builderBuild);
             }
 
             inline bool IsValid() const { return builder != nullptr; }
+
+        private:
+            // The setters return this builder, as a new local ref that is dropped right away.
+            template <typename... args_t>
+            void Call(jmethodID method, args_t... args)
+            {
+                jobject self = env->CallObjectMethod(builder, method, args...);
+                if (self)
+                    env->DeleteLocalRef(self);
+            }
         };
 
+        // Wraps a Java SurfaceControl.Transaction. Either creates a new one, or operates on an
+        // existing one (e.g. a global ref kept across frames) without taking ownership.
         class Transaction
         {
         public:
             JNIEnv *env;
             jobject transaction;
-            jclass transactionClass;
+            const jni::ClassCache *ids;
+            bool owned;
 
-            Transaction(JNIEnv *e) : env(e), transaction(nullptr), transactionClass(nullptr)
+            Transaction(JNIEnv *e) : env(e), transaction(nullptr), ids(jni::ClassCache::Get(e)), owned(true)
             {
-                transactionClass = env->FindClass("android/view/SurfaceControl$Transaction");
-                if (!transactionClass)
+                if (!ids || !ids->transactionCtor)
                     return;
 
-                jmethodID ctor = env->GetMethodID(transactionClass, "<init>", "()V");
-                transaction = env->NewObject(transactionClass, ctor);
+                transaction = env->NewObject(ids->transaction, ids->transactionCtor);
+            }
+
+            Transaction(JNIEnv *e, jobject existing) : env(e), transaction(existing), ids(jni::ClassCache::Get(e)), owned(false)
+            {
+                if (!ids)
+                    transaction = nullptr;
             }
 
             ~Transaction()
             {
-                if (env && transaction)
+                if (env && transaction && owned)
                     env->DeleteLocalRef(transaction);
-                if (env && transactionClass)
-                    env->DeleteLocalRef(transactionClass);
             }
 
+            Transaction(const Transaction &) = delete;
+            Transaction &operator=(const Transaction &) = delete;
+
             Transaction &SetAlpha(jobject surfaceControl, float alpha)
             {
-                if (!transaction || !surfaceControl)
-                    return *this;
-
-                jmethodID setAlpha = env->GetMethodID(transactionClass, "setAlpha",
-                                                      "(Landroid/view/SurfaceControl;F)Landroid/view/SurfaceControl$Transaction;");
-                if (setAlpha)
-                {
-                    transaction = env->CallObjectMethod(transaction, setAlpha, surfaceControl, alpha);
-                }
+                if (transaction && surfaceControl)
+                    Call(ids->transactionSetAlpha, surfaceControl, alpha);
                 return *this;
             }
 
             Transaction &SetLayer(jobject surfaceControl, int32_t z)
             {
-                if (!transaction || !surfaceControl)
-                    return *this;
+                if (transaction && surfaceControl)
+                    Call(ids->transactionSetLayer, surfaceControl, z);
+                return *this;
+            }
 
-                jmethodID setLayer = env->GetMethodID(transactionClass, "setLayer",
-                                                      "(Landroid/view/SurfaceControl;I)Landroid/view/SurfaceControl$Transaction;");
-                if (setLayer)
-                {
-                    transaction = env->CallObjectMethod(transaction, setLayer, surfaceControl, z);
-                }
+            Transaction &SetPosition(jobject surfaceControl, float x, float y)
+            {
+                if (transaction && surfaceControl)
+                    Call(ids->transactionSetPosition, surfaceControl, x, y);
                 return *this;
             }
 
-            Transaction &Show(jobject surfaceControl)
+            Transaction &SetBufferSize(jobject surfaceControl, int32_t width, int32_t height)
+            {
+                if (transaction && surfaceControl)
+                    Call(ids->transactionSetBufferSize, surfaceControl, width, height);
+                return *this;
+            }
+
+            // setScale is public since API 31, older releases only have the hidden setMatrix.
+            Transaction &SetScale(jobject surfaceControl, float scaleX, float scaleY)
             {
                 if (!transaction || !surfaceControl)
                     return *this;
 
-                jmethodID show = env->GetMethodID(transactionClass, "show",
-                                    "(Landroid/view/SurfaceControl;)Landroid/view/SurfaceControl$Transaction;");
-                if (show)
-                {
-                    transaction = env->CallObjectMethod(transaction, show, surfaceControl);
-                }
+                if (ids->transactionSetScale)
+                    Call(ids->transactionSetScale, surfaceControl, scaleX, scaleY);
+                else
+                    Call(ids->transactionSetMatrix, surfaceControl, scaleX, 0.0f, 0.0f, scaleY);
                 return *this;
             }
 
-            Transaction &Hide(jobject surfaceControl)
+            // An empty crop (all zero) removes it.
+            Transaction &SetCrop(jobject surfaceControl, int32_t left, int32_t top, int32_t right, int32_t bottom)
             {
-                if (!transaction || !surfaceControl)
+                if (!transaction || !surfaceControl || !ids->rectCtor || !ids->transactionSetCrop)
                     return *this;
 
-                jmethodID hide = env->GetMethodID(transactionClass, "hide",
-                                                  "(Landroid/view/SurfaceControl;)Landroid/view/SurfaceControl$Transaction;");
-                if (hide)
-                {
-                    transaction = env->CallObjectMethod(transaction, hide, surfaceControl);
-                }
+                jni::LocalRef crop(env, env->NewObject(ids->rect, ids->rectCtor, left, top, right, bottom));
+                if (crop)
+                    Call(ids->transactionSetCrop, surfaceControl, crop.get());
                 return *this;
             }
 
-            Transaction &Remove(jobject surfaceControl)
+            // API 30. 0 withdraws the vote, compatibility is FRAME_RATE_COMPATIBILITY_DEFAULT.
+            Transaction &SetFrameRate(jobject surfaceControl, float frameRate)
             {
-                if (!transaction || !surfaceControl)
-                    return *this;
+                if (transaction && surfaceControl && ids->transactionSetFrameRate)
+                    Call(ids->transactionSetFrameRate, surfaceControl, frameRate, static_cast<jint>(0));
+                return *this;
+            }
 
-                jmethodID remove = env->GetMethodID(transactionClass, "remove",
-                                                    "(Landroid/view/SurfaceControl;)Landroid/view/SurfaceControl$Transaction;");
-                if (remove)
-                {
-                    transaction = env->CallObjectMethod(transaction, remove, surfaceControl);
-                }
+            Transaction &SetOpaque(jobject surfaceControl, bool opaque)
+            {
+                if (transaction && surfaceControl && ids->transactionSetOpaque)
+                    Call(ids->transactionSetOpaque, surfaceControl, static_cast<jboolean>(opaque));
+                return *this;
+            }
+
+            Transaction &Show(jobject surfaceControl)
+            {
+                if (transaction && surfaceControl)
+                    Call(ids->transactionShow, surfaceControl);
+                return *this;
+            }
+
+            Transaction &Hide(jobject surfaceControl)
+            {
+                if (transaction && surfaceControl)
+                    Call(ids->transactionHide, surfaceControl);
+                return *this;
+            }
+
+            Transaction &Remove(jobject surfaceControl)
+            {
+                if (transaction && surfaceControl)
+                    Call(ids->transactionRemove, surfaceControl);
                 return *this;
             }
 
+            // Applying empties the transaction, it can be reused for the next update.
             void Apply()
             {
                 if (!transaction)
                     return;
 
-                jmethodID apply = env->GetMethodID(transactionClass, "apply", "()V");
-                if (apply)
+                if (ids->transactionApply)
                 {
-                    env->CallVoidMethod(transaction, apply);
+                    env->CallVoidMethod(transaction, ids->transactionApply);
                 }
             }
 
+            // Waits for the last applied transaction (static, removed after API 29).
+            void Sync()
+            {
+                if (ids && ids->transactionSync)
+                    env->CallStaticVoidMethod(ids->transaction, ids->transactionSync);
+            }
+
             inline bool IsValid() const { return transaction != nullptr; }
+
+        private:
+            // The setters return this transaction, as a new local ref that is dropped right away.
+            template <typename... args_t>
+            void Call(jmethodID method, args_t... args)
+            {
+                if (!transaction || !method)
+                    return;
+
+                jobject self = env->CallObjectMethod(transaction, method, args...);
+                if (self)
+                    env->DeleteLocalRef(self);
+            }
         };
 
         static jobject GetParentSurfaceControl(JNIEnv *env, ANativeActivity *activity)
@@ -487,40 +967,24 @@ namespace android::anwcreator::detail::framework
             if (!env || !activity || !activity->clazz)
                 return nullptr;
 
-            jni::LocalRef activityCls(env, env->GetObjectClass(activity->clazz));
-            jmethodID getWindow = env->GetMethodID(activityCls, "getWindow", "()Landroid/view/Window;");
-            if (!getWindow)
+            const jni::ClassCache *ids = jni::ClassCache::Get(env);
+            if (!ids || !ids->activityGetWindow || !ids->windowGetDecorView ||
+                !ids->viewGetViewRootImpl || !ids->viewRootImplGetSurfaceControl)
                 return nullptr;
 
-            jni::LocalRef window(env, env->CallObjectMethod(activity->clazz, getWindow));
+            jni::LocalRef window(env, env->CallObjectMethod(activity->clazz, ids->activityGetWindow));
             if (!window)
                 return nullptr;
 
-            jni::LocalRef windowCls(env, env->GetObjectClass(window));
-            jmethodID getDecorView = env->GetMethodID(windowCls, "getDecorView", "()Landroid/view/View;");
-            if (!getDecorView)
-                return nullptr;
-
-            jni::LocalRef decorView(env, env->CallObjectMethod(window, getDecorView));
+            jni::LocalRef decorView(env, env->CallObjectMethod(window, ids->windowGetDecorView));
             if (!decorView)
                 return nullptr;
 
-            jni::LocalRef viewCls(env, env->GetObjectClass(decorView));
-            jmethodID getViewRootImpl = env->GetMethodID(viewCls, "getViewRootImpl", "()Landroid/view/ViewRootImpl;");
-            if (!getViewRootImpl)
-                return nullptr;
-
-            jni::LocalRef viewRootImpl(env, env->CallObjectMethod(decorView, getViewRootImpl));
+            jni::LocalRef viewRootImpl(env, env->CallObjectMethod(decorView, ids->viewGetViewRootImpl));
             if (!viewRootImpl)
                 return nullptr;
 
-            jni::LocalRef viewRootImplCls(env, env->GetObjectClass(viewRootImpl));
-            jmethodID getSurfaceControl = env->GetMethodID(viewRootImplCls, "getSurfaceControl",
-                                                           "()Landroid/view/SurfaceControl;");
-            if (!getSurfaceControl)
-                return nullptr;
-
-            return env->CallObjectMethod(viewRootImpl, getSurfaceControl);
+            return env->CallObjectMethod(viewRootImpl, ids->viewRootImplGetSurfaceControl);
         }
     };
 
@@ -532,15 +996,11 @@ namespace android::anwcreator::detail::framework
             if (!env || !surfaceControl)
                 return nullptr;
 
-            jni::LocalRef surfaceCls(env, env->FindClass("android/view/Surface"));
-            if (!surfaceCls)
-                return nullptr;
-
-            jmethodID ctor = env->GetMethodID(surfaceCls, "<init>", "(Landroid/view/SurfaceControl;)V");
-            if (!ctor)
+            const jni::ClassCache *ids = jni::ClassCache::Get(env);
+            if (!ids || !ids->surfaceCtor)
                 return nullptr;
 
-            return env->NewObject(surfaceCls, ctor, surfaceControl);
+            return env->NewObject(ids->surface, ids->surfaceCtor, surfaceControl);
         }
     };
 
@@ -548,22 +1008,160 @@ namespace android::anwcreator::detail::framework
 
 namespace android::anwcreator::detail
 {
+    // Layer properties that go through a transaction.
+    struct LayerState
+    {
+        enum Property : uint32_t
+        {
+            Visibility = 1 << 0,
+            Alpha = 1 << 1,
+            Layer = 1 << 2,
+            Position = 1 << 3,
+            Scale = 1 << 4,
+            BufferSize = 1 << 5,
+            Crop = 1 << 6,
+            FrameRate = 1 << 7,
+            Opacity = 1 << 8,
+        };
+
+        bool visible = true;
+        float alpha = 1.0f;
+        int32_t layer = 0;
+        int32_t x = 0;
+        int32_t y = 0;
+        float scaleX = 1.0f;
+        float scaleY = 1.0f;
+        int32_t bufferWidth = 0;
+        int32_t bufferHeight = 0;
+        native::Rect crop; // empty = no crop
+        float frameRate = 0.0f; // 0 = no preference
+        bool opaque = false;
+
+        // True when `property` has the same value in both states.
+        bool Matches(const LayerState &other, uint32_t property) const
+        {
+            switch (property)
+            {
+            case Visibility:
+                return visible == other.visible;
+            case Alpha:
+                return alpha == other.alpha;
+            case Layer:
+                return layer == other.layer;
+            case Position:
+                return x == other.x && y == other.y;
+            case Scale:
+                return scaleX == other.scaleX && scaleY == other.scaleY;
+            case BufferSize:
+                return bufferWidth == other.bufferWidth && bufferHeight == other.bufferHeight;
+            case Crop:
+                return crop.left == other.crop.left && crop.top == other.crop.top &&
+                       crop.right == other.crop.right && crop.bottom == other.crop.bottom;
+            case FrameRate:
+                return frameRate == other.frameRate;
+            case Opacity:
+                return opaque == other.opaque;
+            default:
+                return false;
+            }
+        }
+    };
+
+    struct TransactionStats
+    {
+        uint64_t transactionsApplied = 0;
+        uint64_t propertiesApplied = 0;
+        uint64_t propertiesCoalesced = 0; // overwritten before being applied, or set to the applied value
+    };
+
+    // Collects layer property changes until the next apply. Only the last value of a
+    // property goes out, and none at all when it ends up where it already was.
+    class PendingTransaction
+    {
+    public:
+        // Both states start at `applied`, e.g. after the layer was set up in one go.
+        void Reset(const LayerState &applied)
+        {
+            m_pending = applied;
+            m_applied = applied;
+            m_dirty = 0;
+        }
+
+        // Changes the pending state through `update`, which touches only `property`.
+        template <typename update_t>
+        void Set(LayerState::Property property, update_t &&update)
+        {
+            if (m_dirty & property)
+                ++m_stats.propertiesCoalesced;
+
+            update(m_pending);
+
+            if (m_pending.Matches(m_applied, property))
+            {
+                if (!(m_dirty & property))
+                    ++m_stats.propertiesCoalesced;
+                m_dirty &= ~property;
+                return;
+            }
+            m_dirty |= property;
+        }
+
+        uint32_t GetDirty() const { return m_dirty; }
+        const LayerState &GetPending() const { return m_pending; }
+        const TransactionStats &GetStats() const { return m_stats; }
+
+        // Call after the dirty properties went out in one transaction.
+        void MarkApplied()
+        {
+            if (!m_dirty)
+                return;
+
+            ++m_stats.transactionsApplied;
+            m_stats.propertiesApplied += __builtin_popcount(m_dirty);
+            m_applied = m_pending;
+            m_dirty = 0;
+        }
+
+    private:
+        LayerState m_pending;
+        LayerState m_applied;
+        uint32_t m_dirty = 0;
+        TransactionStats m_stats;
+    };
+
     struct WindowContext
     {
         std::unique_ptr<jni::GlobalRef> surfaceControl;
         std::unique_ptr<jni::GlobalRef> surface;
         ANativeWindow *nativeWindow;
+        ASurfaceControl *nativeSurfaceControl; // NDK handle of surfaceControl, property updates skip JNI
+        int32_t x;
+        int32_t y;
         int32_t width;
         int32_t height;
+        int32_t preRotation; // quarter turns clockwise the producer renders with, see ANwCreator::SetPreRotation()
         bool skipScreenshot;
+        bool canSetFrameRate; // the path in use has a frame rate setter (API 30+)
+
+        // Property changes wait here for ANwCreator::Apply(), which reuses one transaction
+        // per window. Staging and applying may happen on different threads.
+        std::mutex mutex;
+        PendingTransaction pending;
+        std::unique_ptr<jni::GlobalRef> transaction;
+        std::unique_ptr<native::Transaction> nativeTransaction;
 
         WindowContext()
             : surfaceControl(nullptr),
               surface(nullptr),
               nativeWindow(nullptr),
+              nativeSurfaceControl(nullptr),
+              x(0),
+              y(0),
               width(0),
               height(0),
-              skipScreenshot(false)
+              preRotation(0),
+              skipScreenshot(false),
+              canSetFrameRate(false)
         {
         }
 
@@ -579,11 +1177,133 @@ namespace android::anwcreator::detail
                 ANativeWindow_release(nativeWindow);
                 nativeWindow = nullptr;
             }
+            nativeTransaction.reset();
+            transaction.reset();
+            if (nativeSurfaceControl)
+            {
+                native::SurfaceControlApi::Get().release(nativeSurfaceControl);
+                nativeSurfaceControl = nullptr;
+            }
             surface.reset();
             surfaceControl.reset();
         }
     };
 
+    // The live overlays, keyed by their ANativeWindow. Slots never move, which lets
+    // IsValid()/GetSize() run without any lock: a slot publishes its window with release
+    // and acquire and keeps the layer size packed into one atomic. Insert/Remove take the
+    // mutex exclusively; context lookups share it, so overlays applying from their own
+    // threads do not wait for each other. A context handed out by Find() stays alive even
+    // if the window is removed meanwhile.
+    class WindowRegistry
+    {
+    public:
+        static constexpr size_t kMaxWindows = 16;
+
+        bool Insert(std::shared_ptr<WindowContext> context)
+        {
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+            for (Slot &slot : m_slots)
+            {
+                if (slot.context)
+                    continue;
+
+                slot.size.store(Pack(context->width, context->height), std::memory_order_relaxed);
+                slot.window.store(context->nativeWindow, std::memory_order_release);
+                slot.context = std::move(context);
+                return true;
+            }
+            return false;
+        }
+
+        std::shared_ptr<WindowContext> Remove(ANativeWindow *window)
+        {
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+            Slot *slot = FindSlot(window);
+            if (!slot)
+                return nullptr;
+
+            slot->window.store(nullptr, std::memory_order_release);
+            return std::move(slot->context);
+        }
+
+        std::shared_ptr<WindowContext> Find(ANativeWindow *window) const
+        {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            const Slot *slot = FindSlot(window);
+            return slot ? slot->context : nullptr;
+        }
+
+        bool Contains(ANativeWindow *window) const { return FindSlot(window); }
+
+        bool GetSize(ANativeWindow *window, int32_t &width, int32_t &height) const
+        {
+            const Slot *slot = FindSlot(window);
+            if (!slot)
+                return false;
+
+            const uint64_t size = slot->size.load(std::memory_order_acquire);
+            // Removed (and maybe reused) since FindSlot(), the size belongs to someone else.
+            if (slot->window.load(std::memory_order_acquire) != window)
+                return false;
+
+            width = static_cast<int32_t>(size >> 32);
+            height = static_cast<int32_t>(size & 0xFFFFFFFF);
+            return true;
+        }
+
+        void SetSize(ANativeWindow *window, int32_t width, int32_t height)
+        {
+            // Shared is enough, the lock only has to keep the slot from being reassigned.
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            if (Slot *slot = FindSlot(window))
+                slot->size.store(Pack(width, height), std::memory_order_release);
+        }
+
+        size_t GetCount() const
+        {
+            size_t count = 0;
+            for (const Slot &slot : m_slots)
+                count += slot.window.load(std::memory_order_relaxed) != nullptr;
+            return count;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<ANativeWindow *> window{nullptr};
+            std::atomic<uint64_t> size{0}; // width << 32 | height
+            std::shared_ptr<WindowContext> context; // guarded by m_mutex
+        };
+
+        static uint64_t Pack(int32_t width, int32_t height)
+        {
+            return static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32 | static_cast<uint32_t>(height);
+        }
+
+        const Slot *FindSlot(ANativeWindow *window) const
+        {
+            if (!window)
+                return nullptr;
+
+            for (const Slot &slot : m_slots)
+            {
+                if (slot.window.load(std::memory_order_acquire) == window)
+                    return &slot;
+            }
+            return nullptr;
+        }
+
+        Slot *FindSlot(ANativeWindow *window)
+        {
+            return const_cast<Slot *>(static_cast<const WindowRegistry *>(this)->FindSlot(window));
+        }
+
+    private:
+        mutable std::shared_mutex m_mutex;
+        std::array<Slot, kMaxWindows> m_slots;
+    };
+
 } // namespace android::anwcreator::detail
 
 namespace android
@@ -597,30 +1317,50 @@ namespace android
             int32_t width;
             int32_t height;
             float refreshRate;
+            float density;
+            int32_t densityDpi;
+            uint32_t generation; // changes whenever any of the above does
 
             DisplayInfo()
-                : theta(0), width(0), height(0), refreshRate(60.0f)
+                : theta(0), width(0), height(0), refreshRate(60.0f), density(1.0f), densityDpi(160), generation(0)
             {
             }
         };
 
+        using SurfaceControlFlags = anwcreator::detail::types::SurfaceControlFlags;
+        using TransactionStats = anwcreator::detail::TransactionStats;
+
+        // Topmost layer below the system's own overlays.
+        static constexpr int32_t kDefaultLayer = 0x7FFFFFFE;
+        static constexpr size_t kMaxWindows = anwcreator::detail::WindowRegistry::kMaxWindows;
+
         struct CreateOptions
         {
             const char *name;
-            int32_t width;
+            int32_t width;        // layer size, -1 covers the display
             int32_t height;
+            int32_t bufferWidth;  // -1 matches the layer, smaller buffers are scaled up
+            int32_t bufferHeight;
+            int32_t layer;        // z-order among the overlays, higher is on top
+            SurfaceControlFlags flags; // eHidden starts the overlay hidden, eOpaque skips blending
             bool skipScreenshot;
 
             CreateOptions()
                 : name(""),
                   width(-1),
                   height(-1),
+                  bufferWidth(-1),
+                  bufferHeight(-1),
+                  layer(kDefaultLayer),
+                  flags(static_cast<SurfaceControlFlags>(0)),
                   skipScreenshot(false)
             {
             }
         };
 
     public:
+        // Cached display state. Only the first call for an activity queries Java, after that
+        // it is a lock-free read that PollDisplay() keeps up to date, cheap enough for every frame.
         static DisplayInfo GetDisplayInfo(ANativeActivity *activity)
         {
             DisplayInfo result{};
@@ -628,20 +1368,46 @@ namespace android
             if (!activity || !activity->vm || !activity->clazz)
                 return result;
 
-            anwcreator::detail::jni::JNIEnvironment jniEnv(activity->vm);
-            if (!jniEnv.IsValid())
-                return result;
+            if (!m_displayMonitor.IsValidFor(activity))
+            {
+                anwcreator::detail::jni::JNIEnvironment jniEnv(activity->vm);
+                if (!jniEnv.IsValid() || !m_displayMonitor.Refresh(jniEnv, activity))
+                    return result;
+            }
 
-            auto displayInfo = anwcreator::detail::framework::Display::GetDisplayInfo(jniEnv, activity);
+            auto displayInfo = m_displayMonitor.Get();
 
             result.width = displayInfo.width;
             result.height = displayInfo.height;
             result.theta = 90 * static_cast<int32_t>(displayInfo.rotation);
             result.refreshRate = displayInfo.refreshRate;
+            if (displayInfo.density > 0.0f)
+                result.density = displayInfo.density;
+            if (displayInfo.densityDpi > 0)
+                result.densityDpi = displayInfo.densityDpi;
+            result.generation = displayInfo.generation;
 
             return result;
         }
 
+        // Re-checks the display at most every minInterval ns, meant to be called once per
+        // frame. Returns true when GetDisplayInfo() changed (rotation, size, refresh rate, density).
+        static bool PollDisplay(ANativeActivity *activity, int64_t minInterval = 250000000)
+        {
+            if (!activity || !activity->vm)
+                return false;
+
+            if (!m_displayMonitor.IsValidFor(activity))
+                return GetDisplayInfo(activity).generation != 0;
+
+            const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch())
+                                    .count();
+
+            anwcreator::detail::jni::JNIEnvironment jniEnv(activity->vm);
+            return jniEnv.IsValid() && m_displayMonitor.Poll(jniEnv, now, minInterval);
+        }
+
         static ANativeWindow *Create(ANativeActivity *activity, const CreateOptions &options = CreateOptions())
         {
             if (!activity || !activity->vm || !activity->clazz)
@@ -651,6 +1417,9 @@ namespace android
             if (!jniEnv.IsValid())
                 return nullptr;
 
+            // Every local ref below (parent, builder, SurfaceControl, Surface) goes with the frame.
+            anwcreator::detail::jni::LocalFrame frame(jniEnv);
+
             char sdkBuf[PROP_VALUE_MAX]{0};
             __system_property_get("ro.build.version.sdk", sdkBuf);
             const int apiLevel = atoi(sdkBuf);
@@ -660,11 +1429,24 @@ namespace android
         
             if (width <= 0 || height <= 0)
             {
-                auto displayInfo = anwcreator::detail::framework::Display::GetDisplayInfo(jniEnv, activity);
+                auto displayInfo = GetDisplayInfo(activity);
                 width = displayInfo.width;
                 height = displayInfo.height;
             }
 
+            int32_t bufferWidth = width;
+            int32_t bufferHeight = height;
+            if (options.bufferWidth > 0 && options.bufferHeight > 0)
+            {
+                bufferWidth = options.bufferWidth;
+                bufferHeight = options.bufferHeight;
+            }
+
+            const uint32_t flags = static_cast<uint32_t>(options.flags);
+            const bool visible = !(flags & static_cast<uint32_t>(SurfaceControlFlags::eHidden));
+            const float scaleX = static_cast<float>(width) / bufferWidth;
+            const float scaleY = static_cast<float>(height) / bufferHeight;
+
             jobject parentSC = anwcreator::detail::framework::SurfaceControl::GetParentSurfaceControl(jniEnv, activity);
             if (!parentSC && jniEnv.CheckException("GetParentSurfaceControl"))
                 return nullptr;
@@ -673,7 +1455,9 @@ namespace android
             if (!builder.IsValid())
                 return nullptr;
         
-            builder.SetName(options.name).SetBufferSize(width, height).SetSkipScreenshot(options.skipScreenshot);
+            builder.SetName(options.name).SetBufferSize(bufferWidth, bufferHeight).SetSkipScreenshot(options.skipScreenshot);
+            if (flags)
+                builder.SetFlags(flags, flags);
 
             if (apiLevel == 29)
             {
@@ -690,72 +1474,90 @@ namespace android
         
             jobject localSurfaceControl = builder.Build();
             if (!localSurfaceControl || jniEnv.CheckException("Builder.build()"))
-            {
-                if (parentSC)
-                    jniEnv->DeleteLocalRef(parentSC);
                 return nullptr;
-            }
 
-            auto context = std::make_unique<anwcreator::detail::WindowContext>();
+            auto context = std::make_shared<anwcreator::detail::WindowContext>();
             context->width = width;
             context->height = height;
             context->skipScreenshot = options.skipScreenshot;
             context->surfaceControl = std::make_unique<anwcreator::detail::jni::GlobalRef>(jniEnv, localSurfaceControl);
 
+            // The layer itself has to come from Java, it is the only way to get a Surface (and an
+            // ANativeWindow for EGL) for it. From here on it is driven through the NDK when possible.
+            const auto &api = anwcreator::native::SurfaceControlApi::Get();
+            if (api.IsValid())
+                context->nativeSurfaceControl = api.fromJava(jniEnv.env, context->surfaceControl->get());
+
+            if (context->nativeSurfaceControl)
+            {
+                context->canSetFrameRate = api.setFrameRate != nullptr;
+            }
+            else
+            {
+                const anwcreator::detail::jni::ClassCache *ids = anwcreator::detail::jni::ClassCache::Get(jniEnv.env);
+                context->canSetFrameRate = ids && ids->transactionSetFrameRate;
+            }
+
+            // eHidden already hides the layer, it only has to stay that way.
+            const bool scaled = bufferWidth != width || bufferHeight != height;
+            if (context->nativeSurfaceControl)
+            {
+                anwcreator::native::Transaction transaction(api);
+                transaction
+                    .SetAlpha(context->nativeSurfaceControl, 1.0f)
+                    .SetLayer(context->nativeSurfaceControl, options.layer)
+                    .SetVisible(context->nativeSurfaceControl, visible);
+                if (scaled)
+                    transaction.SetScale(context->nativeSurfaceControl, scaleX, scaleY);
+                transaction.Apply();
+            }
+            else
             {
                 anwcreator::detail::framework::SurfaceControl::Transaction transaction(jniEnv);
                 if (transaction.IsValid())
                 {
                     transaction
                         .SetAlpha(context->surfaceControl->get(), 1.0f)
-                        .SetLayer(context->surfaceControl->get(), 0x7FFFFFFE)
-                        .Show(context->surfaceControl->get())
-                        .Apply();
+                        .SetLayer(context->surfaceControl->get(), options.layer);
+                    if (visible)
+                        transaction.Show(context->surfaceControl->get());
+                    if (scaled)
+                        transaction.SetScale(context->surfaceControl->get(), scaleX, scaleY);
+                    transaction.Apply();
 
                     if (apiLevel == 29)
-                    {
-                        jclass tCls = jniEnv->GetObjectClass(transaction.transaction);
-                        if (tCls)
-                        {
-                            jmethodID syncMethod = jniEnv->GetStaticMethodID(tCls, "sync", "()V");
-                            if (syncMethod)
-                                jniEnv->CallStaticVoidMethod(tCls, syncMethod);
-                            jniEnv->DeleteLocalRef(tCls);
-                        }
-                    }
+                        transaction.Sync();
                 }
             }
 
+            LayerState applied;
+            applied.visible = visible;
+            applied.opaque = flags & static_cast<uint32_t>(SurfaceControlFlags::eOpaque);
+            applied.layer = options.layer;
+            applied.scaleX = scaleX;
+            applied.scaleY = scaleY;
+            applied.bufferWidth = bufferWidth;
+            applied.bufferHeight = bufferHeight;
+            context->pending.Reset(applied);
+
             jobject localSurface = anwcreator::detail::framework::Surface::CreateFromSurfaceControl(jniEnv, context->surfaceControl->get());
         
             if (!localSurface || jniEnv.CheckException("Create Surface"))
-            {
-                jniEnv->DeleteLocalRef(localSurfaceControl);
-                if (parentSC)
-                    jniEnv->DeleteLocalRef(parentSC);
                 return nullptr;
-            }
         
             context->surface = std::make_unique<anwcreator::detail::jni::GlobalRef>(jniEnv, localSurface);
             context->nativeWindow = ANativeWindow_fromSurface(jniEnv, context->surface->get());
         
             if (!context->nativeWindow)
-            {
-                jniEnv->DeleteLocalRef(localSurface);
-                jniEnv->DeleteLocalRef(localSurfaceControl);
-                if (parentSC)
-                    jniEnv->DeleteLocalRef(parentSC);
                 return nullptr;
-            }
         
             ANativeWindow *result = context->nativeWindow;
-            m_windowContexts.emplace(result, std::move(context));
-        
-            jniEnv->DeleteLocalRef(localSurface);
-            jniEnv->DeleteLocalRef(localSurfaceControl);
-            if (parentSC)
-                jniEnv->DeleteLocalRef(parentSC);
-        
+            if (!m_windows.Insert(context))
+            {
+                LogError("Too many overlays, at most %zu", kMaxWindows);
+                RemoveLayer(activity, *context);
+                return nullptr;
+            }
             return result;
         }
 
@@ -764,51 +1566,347 @@ namespace android
             if (!nativeWindow)
                 return;
 
-            auto it = m_windowContexts.find(nativeWindow);
-            if (it == m_windowContexts.end())
+            auto context = m_windows.Remove(nativeWindow);
+            if (!context)
             {
                 ANativeWindow_release(nativeWindow);
                 return;
             }
 
-            auto &context = it->second;
+            // An Apply() still running on another thread finishes first, later ones find
+            // the context released.
+            std::lock_guard<std::mutex> lock(context->mutex);
+            RemoveLayer(activity, *context);
+        }
+
+        static size_t GetWindowCount()
+        {
+            return m_windows.GetCount();
+        }
+
+        // The setters below only stage the change, it shows up with the next Apply(). Setting
+        // a property several times in between costs nothing extra.
+        static bool SetVisible(ANativeWindow *nativeWindow, bool visible)
+        {
+            return Stage(nativeWindow, Property::Visibility, [visible](LayerState &state)
+                         { state.visible = visible; });
+        }
+
+        static bool SetAlpha(ANativeWindow *nativeWindow, float alpha)
+        {
+            return Stage(nativeWindow, Property::Alpha, [alpha](LayerState &state)
+                         { state.alpha = alpha; });
+        }
+
+        static bool SetLayer(ANativeWindow *nativeWindow, int32_t z)
+        {
+            return Stage(nativeWindow, Property::Layer, [z](LayerState &state)
+                         { state.layer = z; });
+        }
+
+        // Crop in buffer coordinates, an empty rect removes it.
+        static bool SetCrop(ANativeWindow *nativeWindow, int32_t left, int32_t top, int32_t right, int32_t bottom)
+        {
+            return Stage(nativeWindow, Property::Crop, [&](LayerState &state)
+                         { state.crop = anwcreator::native::Rect{left, top, right, bottom}; });
+        }
+
+        // Tells the compositor how often the content changes, so the display can drop to a
+        // lower refresh rate while nothing else needs more. 0 withdraws the vote. API 30+,
+        // before that it fails and stages nothing, so Apply() has no empty transaction to send.
+        static bool SetFrameRate(ANativeWindow *nativeWindow, float frameRate)
+        {
+            auto context = m_windows.Find(nativeWindow);
+            if (!context || !context->canSetFrameRate)
+                return false;
+
+            std::lock_guard<std::mutex> lock(context->mutex);
+            context->pending.Set(Property::FrameRate, [frameRate](LayerState &state)
+                                 { state.frameRate = frameRate > 0.0f ? frameRate : 0.0f; });
+            return true;
+        }
+
+        // An opaque layer is never blended with what is below it and its alpha channel is
+        // ignored, which keeps it eligible for a hardware overlay plane.
+        static bool SetOpaque(ANativeWindow *nativeWindow, bool opaque)
+        {
+            return Stage(nativeWindow, Property::Opacity, [opaque](LayerState &state)
+                         { state.opaque = opaque; });
+        }
+
+        // Pre-rotation: the producer renders its content already turned quarterTurns * 90
+        // degrees clockwise (the display rotation, GetDisplayInfo().theta / 90) into a buffer
+        // in the panel's native orientation, and the buffer transform turns it back. That
+        // cancels the display's own rotation, so the compositor scans the buffer out as is
+        // instead of rotating it, often on the GPU. Layer size and geometry stay in display
+        // orientation, only the buffers are swapped. Takes effect with the next buffer.
+        // Needs API 26 (ANativeWindow_setBuffersTransform), fails and changes nothing before.
+        static bool SetPreRotation(ANativeWindow *nativeWindow, int32_t quarterTurns)
+        {
+            static constexpr int32_t kBufferTransforms[4] = {
+                ANATIVEWINDOW_TRANSFORM_IDENTITY,
+                ANATIVEWINDOW_TRANSFORM_ROTATE_270,
+                ANATIVEWINDOW_TRANSFORM_ROTATE_180,
+                ANATIVEWINDOW_TRANSFORM_ROTATE_90,
+            };
+
+            const auto setBuffersTransform = anwcreator::native::SurfaceControlApi::Get().setBuffersTransform;
+            auto context = m_windows.Find(nativeWindow);
+            if (!context || !setBuffersTransform)
+                return false;
+
+            quarterTurns &= 3;
+            if (0 != setBuffersTransform(nativeWindow, kBufferTransforms[quarterTurns]))
+                return false;
 
-            if (activity && activity->vm && context->surfaceControl && context->surfaceControl->IsValid())
+            int32_t bufferWidth, bufferHeight;
             {
-                anwcreator::detail::jni::JNIEnvironment jniEnv(activity->vm);
-                if (jniEnv.IsValid())
-                {
-                    anwcreator::detail::framework::SurfaceControl::Transaction transaction(jniEnv);
-                    if (transaction.IsValid())
-                        transaction.Remove(context->surfaceControl->get()).Apply();
-                }
+                std::lock_guard<std::mutex> lock(context->mutex);
+                context->preRotation = quarterTurns;
+                bufferWidth = context->pending.GetPending().bufferWidth;
+                bufferHeight = context->pending.GetPending().bufferHeight;
             }
+            if (quarterTurns & 1)
+                std::swap(bufferWidth, bufferHeight);
+
+            return 0 == ANativeWindow_setBuffersGeometry(nativeWindow, bufferWidth, bufferHeight, 0);
+        }
+
+        // True when property updates of this window go through ASurfaceTransaction (API 34+).
+        static bool IsNative(ANativeWindow *nativeWindow)
+        {
+            auto context = m_windows.Find(nativeWindow);
+            if (!context)
+                return false;
 
-            context->Release();
-            m_windowContexts.erase(it);
+            std::lock_guard<std::mutex> lock(context->mutex);
+            return context->nativeSurfaceControl;
         }
 
+        // Moves the layer to cover (x, y, width, height) of the display. The buffer may be
+        // smaller than the layer (bufferWidth/Height), the compositor then scales it up.
+        // The producer side is resized right away, so the next dequeued buffer already has
+        // the new size, the layer follows with the next Apply().
+        static bool SetGeometry(ANativeWindow *nativeWindow, int32_t x, int32_t y, int32_t width, int32_t height,
+                                int32_t bufferWidth = -1, int32_t bufferHeight = -1)
+        {
+            if (width <= 0 || height <= 0)
+                return false;
+
+            if (bufferWidth <= 0 || bufferHeight <= 0)
+            {
+                bufferWidth = width;
+                bufferHeight = height;
+            }
+
+            auto context = m_windows.Find(nativeWindow);
+            if (!context)
+                return false;
+
+            const float scaleX = static_cast<float>(width) / bufferWidth;
+            const float scaleY = static_cast<float>(height) / bufferHeight;
+
+            // What the producer dequeues, turned when pre-rotating.
+            int32_t producerWidth = bufferWidth;
+            int32_t producerHeight = bufferHeight;
+
+            {
+                std::lock_guard<std::mutex> lock(context->mutex);
+                if (context->preRotation & 1)
+                    std::swap(producerWidth, producerHeight);
+
+                context->pending.Set(Property::Position, [&](LayerState &state)
+                                     { state.x = x, state.y = y; });
+                context->pending.Set(Property::Scale, [&](LayerState &state)
+                                     { state.scaleX = scaleX, state.scaleY = scaleY; });
+                context->pending.Set(Property::BufferSize, [&](LayerState &state)
+                                     { state.bufferWidth = bufferWidth, state.bufferHeight = bufferHeight; });
+
+                context->x = x;
+                context->y = y;
+                context->width = width;
+                context->height = height;
+            }
+
+            ANativeWindow_setBuffersGeometry(nativeWindow, producerWidth, producerHeight, 0);
+            m_windows.SetSize(nativeWindow, width, height);
+            return true;
+        }
+
+        // Sends everything staged since the last call in one transaction. Meant to run once
+        // per frame right after eglSwapBuffers, so layer changes land with the buffer they
+        // belong to. Returns true right away when nothing changed.
+        static bool Apply(ANativeActivity *activity, ANativeWindow *nativeWindow)
+        {
+            auto context = m_windows.Find(nativeWindow);
+            if (!context)
+                return false;
+
+            std::lock_guard<std::mutex> lock(context->mutex);
+
+            const uint32_t dirty = context->pending.GetDirty();
+            if (!dirty)
+                return true;
+
+            bool applied = context->nativeSurfaceControl ? ApplyNative(*context, dirty) : ApplyJni(activity, *context, dirty);
+            if (applied)
+                context->pending.MarkApplied();
+            return applied;
+        }
+
+        static bool GetTransactionStats(ANativeWindow *nativeWindow, TransactionStats *outStats)
+        {
+            auto context = m_windows.Find(nativeWindow);
+            if (!context || !outStats)
+                return false;
+
+            std::lock_guard<std::mutex> lock(context->mutex);
+            *outStats = context->pending.GetStats();
+            return true;
+        }
+
+        // IsValid() and GetWindowSize() take no lock, any thread may call them every frame.
         static bool IsValid(ANativeWindow *nativeWindow)
         {
-            return nativeWindow && m_windowContexts.count(nativeWindow) > 0;
+            return m_windows.Contains(nativeWindow);
         }
 
         static bool GetWindowSize(ANativeWindow *nativeWindow, int32_t *outWidth, int32_t *outHeight)
         {
-            auto it = m_windowContexts.find(nativeWindow);
-            if (it == m_windowContexts.end())
+            int32_t width, height;
+            if (!m_windows.GetSize(nativeWindow, width, height))
                 return false;
 
             if (outWidth)
-                *outWidth = it->second->width;
+                *outWidth = width;
             if (outHeight)
-                *outHeight = it->second->height;
+                *outHeight = height;
 
             return true;
         }
 
     private:
-        inline static std::unordered_map<ANativeWindow *, std::unique_ptr<anwcreator::detail::WindowContext>> m_windowContexts;
+        using LayerState = anwcreator::detail::LayerState;
+        using Property = anwcreator::detail::LayerState::Property;
+
+        template <typename update_t>
+        static bool Stage(ANativeWindow *nativeWindow, Property property, update_t &&update)
+        {
+            auto context = m_windows.Find(nativeWindow);
+            if (!context)
+                return false;
+
+            std::lock_guard<std::mutex> lock(context->mutex);
+            context->pending.Set(property, update);
+            return true;
+        }
+
+        // Removal goes out at once, whatever is still pending is dropped with the layer.
+        static void RemoveLayer(ANativeActivity *activity, anwcreator::detail::WindowContext &context)
+        {
+            if (context.nativeSurfaceControl)
+            {
+                anwcreator::native::Transaction(anwcreator::native::SurfaceControlApi::Get())
+                    .Remove(context.nativeSurfaceControl)
+                    .Apply();
+            }
+            else if (activity && activity->vm && context.surfaceControl && context.surfaceControl->IsValid())
+            {
+                anwcreator::detail::jni::JNIEnvironment jniEnv(activity->vm);
+                if (jniEnv.IsValid())
+                {
+                    anwcreator::detail::framework::SurfaceControl::Transaction transaction(jniEnv);
+                    transaction.Remove(context.surfaceControl->get()).Apply();
+                    jniEnv.CheckException("Transaction.apply()");
+                }
+            }
+
+            context.Release();
+        }
+
+        // Natively the layer takes its size from the queued buffer (BLAST), so BufferSize
+        // has nothing to send.
+        static bool ApplyNative(anwcreator::detail::WindowContext &context, uint32_t dirty)
+        {
+            if (!context.nativeTransaction)
+                context.nativeTransaction = std::make_unique<anwcreator::native::Transaction>(anwcreator::native::SurfaceControlApi::Get());
+
+            auto &transaction = *context.nativeTransaction;
+            if (!transaction.IsValid())
+                return false;
+
+            ASurfaceControl *surfaceControl = context.nativeSurfaceControl;
+            const LayerState &state = context.pending.GetPending();
+            if (dirty & Property::Visibility)
+                transaction.SetVisible(surfaceControl, state.visible);
+            if (dirty & Property::Alpha)
+                transaction.SetAlpha(surfaceControl, state.alpha);
+            if (dirty & Property::Layer)
+                transaction.SetLayer(surfaceControl, state.layer);
+            if (dirty & Property::Position)
+                transaction.SetPosition(surfaceControl, state.x, state.y);
+            if (dirty & Property::Scale)
+                transaction.SetScale(surfaceControl, state.scaleX, state.scaleY);
+            if (dirty & Property::Crop)
+                transaction.SetCrop(surfaceControl, state.crop);
+            if (dirty & Property::FrameRate)
+                transaction.SetFrameRate(surfaceControl, state.frameRate);
+            if (dirty & Property::Opacity)
+                transaction.SetOpaque(surfaceControl, state.opaque);
+
+            transaction.Apply();
+            return true;
+        }
+
+        static bool ApplyJni(ANativeActivity *activity, anwcreator::detail::WindowContext &context, uint32_t dirty)
+        {
+            if (!activity || !activity->vm || !context.surfaceControl || !context.surfaceControl->IsValid())
+                return false;
+
+            anwcreator::detail::jni::JNIEnvironment jniEnv(activity->vm);
+            if (!jniEnv.IsValid())
+                return false;
+
+            if (!context.transaction)
+            {
+                anwcreator::detail::framework::SurfaceControl::Transaction created(jniEnv);
+                if (!created.IsValid())
+                    return false;
+                context.transaction = std::make_unique<anwcreator::detail::jni::GlobalRef>(jniEnv, created.transaction);
+            }
+
+            anwcreator::detail::framework::SurfaceControl::Transaction transaction(jniEnv, context.transaction->get());
+            if (!transaction.IsValid())
+                return false;
+
+            jobject surfaceControl = context.surfaceControl->get();
+            const LayerState &state = context.pending.GetPending();
+            if (dirty & Property::Visibility)
+                state.visible ? transaction.Show(surfaceControl) : transaction.Hide(surfaceControl);
+            if (dirty & Property::Alpha)
+                transaction.SetAlpha(surfaceControl, state.alpha);
+            if (dirty & Property::Layer)
+                transaction.SetLayer(surfaceControl, state.layer);
+            if (dirty & Property::Position)
+                transaction.SetPosition(surfaceControl, static_cast<float>(state.x), static_cast<float>(state.y));
+            if (dirty & Property::BufferSize)
+                transaction.SetBufferSize(surfaceControl, state.bufferWidth, state.bufferHeight);
+            if (dirty & Property::Scale)
+                transaction.SetScale(surfaceControl, state.scaleX, state.scaleY);
+            if (dirty & Property::Crop)
+                transaction.SetCrop(surfaceControl, state.crop.left, state.crop.top, state.crop.right, state.crop.bottom);
+            if (dirty & Property::FrameRate)
+                transaction.SetFrameRate(surfaceControl, state.frameRate);
+            if (dirty & Property::Opacity)
+                transaction.SetOpaque(surfaceControl, state.opaque);
+
+            transaction.Apply();
+            return !jniEnv.CheckException("Transaction.apply()");
+        }
+
+    private:
+        inline static anwcreator::detail::WindowRegistry m_windows;
+        inline static anwcreator::detail::framework::DisplayMonitor m_displayMonitor;
     };
 
 } // namespace android
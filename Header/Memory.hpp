@@ -9,6 +9,10 @@
 #include <cstdio>
 #include <iomanip>
 #include <sstream>
+#include <string>
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
 
 namespace Memory
 {
@@ -19,17 +23,8 @@ namespace Memory
         size_t Size;
     };
 
-    inline int FindModuleCallback(dl_phdr_info* info, size_t /*size*/, void* userdata) {
-        auto* d = reinterpret_cast<ModuleData*>(userdata);
-        if (!d || !info) return 0;
-        if (!info->dlpi_name || !*info->dlpi_name) return 0;
-
-        const char* name = info->dlpi_name;
-        const char* base = strrchr(name, '/');
-        const char* modname = base ? base + 1 : name;
-
-        if (d->Name != modname) return 0;
-
+    // Lowest and highest address covered by the module's PT_LOAD segments. False without any.
+    inline bool GetLoadBounds(const dl_phdr_info* info, uintptr_t& Start, uintptr_t& End) {
         uintptr_t s = UINTPTR_MAX, e = 0;
         for (int i = 0; i < info->dlpi_phnum; ++i) {
             const auto& p = info->dlpi_phdr[i];
@@ -38,29 +33,203 @@ namespace Memory
             if (a < s) s = a;
             if (b > e) e = b;
         }
+        if (e <= s) return false;
 
-        if (e > s) d->BaseAddr = s; d->EndAddr = e; d->Size = e - s;
-        return 1;
+        Start = s;
+        End = e;
+        return true;
+    }
+
+    // Every loaded module by file name, filled in one dl_iterate_phdr pass. The loader's
+    // dlpi_adds/dlpi_subs counters tell whether anything changed since the last pass; the
+    // check stops at the first module, so an up to date registry costs O(1) per query.
+    // Loaders without counters (bionic before Android R) are checked by walking the list for
+    // its length and last load address, still without touching the map while nothing changed.
+    // New modules are appended to the loader's list, so additions only walk the tail.
+    class ModuleRegistry
+    {
+    public:
+        // UseLoadCounters = false takes the path of a loader without them even where they
+        // exist, so a host can check it.
+        explicit ModuleRegistry(bool UseLoadCounters = true) : m_useCounters(UseLoadCounters) {}
+
+        static ModuleRegistry& Instance() {
+            static ModuleRegistry registry;
+            return registry;
+        }
+
+        bool Find(const std::string& ModuleName, ModuleData* Out) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Refresh();
+
+            auto it = m_modules.find(ModuleName);
+            if (it == m_modules.end()) return false;
+            if (Out) *Out = it->second;
+            return true;
+        }
+
+        // Number of full walks and incremental (tail only) walks so far.
+        uint64_t GetRebuildCount() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_rebuilds;
+        }
+
+        uint64_t GetUpdateCount() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_updates;
+        }
+
+        // Whether the loader reports dlpi_adds/dlpi_subs, known after the first query.
+        bool HasLoadCounters() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_counters;
+        }
+
+    private:
+        struct WalkState {
+            ModuleRegistry* Registry;
+            unsigned long long Adds;
+            unsigned long long Subs;
+            size_t Index;
+            uintptr_t KnownAddr; // load address of the last module the registry already has
+            uintptr_t LastAddr;  // load address of the last module in the list
+            bool Counters;
+            bool CheckOnly;
+        };
+
+        static int WalkCallback(dl_phdr_info* info, size_t size, void* userdata) {
+            auto* w = reinterpret_cast<WalkState*>(userdata);
+
+            // Counters exist since glibc 2.4, but bionic only has them since Android R (API 30).
+            if (w->CheckOnly) {
+                if (w->Registry->m_useCounters && size >= offsetof(dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs)) {
+                    w->Adds = info->dlpi_adds;
+                    w->Subs = info->dlpi_subs;
+                    w->Counters = true;
+                    return 1;
+                }
+                if (w->Index + 1 == w->Registry->m_count) w->KnownAddr = info->dlpi_addr;
+                w->LastAddr = info->dlpi_addr;
+                ++w->Index;
+                return 0;
+            }
+
+            if (w->Index++ >= w->Registry->m_count) {
+                w->Registry->Add(info);
+                ++w->Registry->m_count;
+            }
+            w->LastAddr = info->dlpi_addr;
+            return 0;
+        }
+
+        void Refresh() {
+            WalkState w{this, 0, 0, 0, 0, 0, false, true};
+            dl_iterate_phdr(WalkCallback, &w);
+
+            // Same counters, or without them the same length ending in the same module.
+            bool append;
+            if (w.Counters) {
+                if (m_valid && w.Adds == m_adds && w.Subs == m_subs) return;
+                append = m_valid && w.Subs == m_subs;
+            } else {
+                if (m_valid && w.Index == m_count && w.LastAddr == m_lastAddr) return;
+                append = m_valid && w.Index > m_count && w.KnownAddr == m_lastAddr;
+            }
+
+            if (!append) {
+                m_modules.clear();
+                m_count = 0;
+                ++m_rebuilds;
+            } else {
+                ++m_updates;
+            }
+
+            w.Index = 0;
+            w.CheckOnly = false;
+            dl_iterate_phdr(WalkCallback, &w);
+
+            m_adds = w.Adds;
+            m_subs = w.Subs;
+            m_lastAddr = w.LastAddr;
+            m_counters = w.Counters;
+            m_valid = true;
+        }
+
+        void Add(dl_phdr_info* info) {
+            if (!info->dlpi_name || !*info->dlpi_name) return;
+
+            const char* name = info->dlpi_name;
+            const char* base = strrchr(name, '/');
+            const char* modname = base ? base + 1 : name;
+
+            uintptr_t s, e;
+            if (!GetLoadBounds(info, s, e)) return;
+
+            // First one wins on duplicate names, as with the linear search.
+            m_modules.emplace(modname, ModuleData{modname, s, e, e - s});
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::unordered_map<std::string, ModuleData> m_modules;
+        size_t m_count = 0;
+        unsigned long long m_adds = 0;
+        unsigned long long m_subs = 0;
+        uintptr_t m_lastAddr = 0;
+        bool m_counters = false;
+        bool m_useCounters;
+        bool m_valid = false;
+        uint64_t m_rebuilds = 0;
+        uint64_t m_updates = 0;
+    };
+
+    inline bool FindModule(const std::string& ModuleName, ModuleData& Out)
+    {
+        return ModuleRegistry::Instance().Find(ModuleName, &Out);
     }
 
     inline uintptr_t FindModuleBase(const std::string& ModuleName)
     {
         ModuleData Data{ModuleName, 0, 0, 0};
-        dl_iterate_phdr(FindModuleCallback, &Data);
+        FindModule(ModuleName, Data);
         return Data.BaseAddr;
     }
 
     inline uintptr_t FindModuleEnd(const std::string& ModuleName)
     {
         ModuleData Data{ModuleName, 0, 0, 0};
-        dl_iterate_phdr(FindModuleCallback, &Data);
+        FindModule(ModuleName, Data);
         return Data.EndAddr;
     }
 
     inline uintptr_t FindModuleSize(const std::string& ModuleName)
     {
         ModuleData Data{ModuleName, 0, 0, 0};
-        dl_iterate_phdr(FindModuleCallback, &Data);
+        FindModule(ModuleName, Data);
         return Data.Size;
-    } 
+    }
+
+    // Blocks until the module is loaded, TimeoutMs < 0 waits forever. There is no load
+    // notification to hook, but with load counters a check is a single dl_iterate_phdr
+    // step, so it can poll every 250us and pick a module up well within a millisecond.
+    // Without them every check walks the whole list under the loader lock, so it backs
+    // off to every 2ms.
+    inline bool WaitForModule(const std::string& ModuleName, ModuleData& Out, int TimeoutMs = -1)
+    {
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const int64_t start = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+
+        bool found = FindModule(ModuleName, Out);
+        const timespec interval{0, ModuleRegistry::Instance().HasLoadCounters() ? 250000L : 2000000L};
+        while (!found) {
+            if (TimeoutMs >= 0) {
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                if (static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec - start >= TimeoutMs * 1000000LL) return false;
+            }
+            nanosleep(&interval, nullptr);
+            found = FindModule(ModuleName, Out);
+        }
+        return true;
+    }
 } // namespace Memory
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <dlfcn.h>
+
+#include <atomic>
+#include <cstdint>
+
+// NDK ASurfaceControl/ASurfaceTransaction entry points, and the ANativeWindow ones newer than
+// the minimum API level, resolved at runtime so the overlay still loads on releases without
+// them. Only standard headers are used here: the table can be filled with a fake
+// implementation and built on any host.
+
+struct ANativeWindow;
+struct ASurfaceControl;
+struct ASurfaceTransaction;
+
+namespace android::anwcreator::native
+{
+
+    // Same layout as ARect from <android/rect.h>.
+    struct Rect
+    {
+        int32_t left = 0;
+        int32_t top = 0;
+        int32_t right = 0;
+        int32_t bottom = 0;
+    };
+
+    struct SurfaceControlApi
+    {
+        // JNIEnv *, jobject (android.view.SurfaceControl). API 34.
+        ASurfaceControl *(*fromJava)(void *env, void *surfaceControl) = nullptr;
+        void (*release)(ASurfaceControl *surfaceControl) = nullptr;
+
+        ASurfaceTransaction *(*transactionCreate)() = nullptr;
+        void (*transactionDelete)(ASurfaceTransaction *transaction) = nullptr;
+        void (*transactionApply)(ASurfaceTransaction *transaction) = nullptr;
+
+        void (*setVisibility)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, int8_t visibility) = nullptr;
+        void (*setZOrder)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, int32_t z) = nullptr;
+        void (*setBufferAlpha)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, float alpha) = nullptr;
+        void (*reparent)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, ASurfaceControl *newParent) = nullptr;
+        // transparency is an ASURFACE_TRANSACTION_TRANSPARENCY_* value.
+        void (*setBufferTransparency)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, int8_t transparency) = nullptr;
+
+        // API 31.
+        void (*setPosition)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, int32_t x, int32_t y) = nullptr;
+        void (*setScale)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, float xScale, float yScale) = nullptr;
+        void (*setCrop)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, const Rect &crop) = nullptr;
+
+        // API 30. compatibility is an ANATIVEWINDOW_FRAME_RATE_COMPATIBILITY_* value.
+        void (*setFrameRate)(ASurfaceTransaction *transaction, ASurfaceControl *surfaceControl, float frameRate, int8_t compatibility) = nullptr;
+
+        // API 26, from libnativewindow.so. transform is an ANATIVEWINDOW_TRANSFORM_* value.
+        int32_t (*setBuffersTransform)(ANativeWindow *window, int32_t transform) = nullptr;
+
+        // Everything needed to take over an existing Java SurfaceControl.
+        bool IsValid() const
+        {
+            return fromJava && release && transactionCreate && transactionDelete && transactionApply &&
+                   setVisibility && setZOrder && setBufferAlpha && reparent;
+        }
+
+        bool HasGeometry() const { return setPosition && setScale; }
+
+        // The libandroid.so table, or the one passed to Override().
+        static const SurfaceControlApi &Get()
+        {
+            if (const SurfaceControlApi *api = s_override.load(std::memory_order_acquire))
+                return *api;
+
+            static const SurfaceControlApi api = Load();
+            return api;
+        }
+
+        // Replaces the system table, e.g. with a fake on a host build. nullptr restores it.
+        static void Override(const SurfaceControlApi *api)
+        {
+            s_override.store(api, std::memory_order_release);
+        }
+
+    private:
+        static SurfaceControlApi Load()
+        {
+            SurfaceControlApi api;
+
+            if (void *nativeWindow = dlopen("libnativewindow.so", RTLD_NOW))
+                Resolve(nativeWindow, "ANativeWindow_setBuffersTransform", api.setBuffersTransform);
+
+            void *library = dlopen("libandroid.so", RTLD_NOW);
+            if (!library)
+                return api;
+
+            Resolve(library, "ASurfaceControl_fromJava", api.fromJava);
+            Resolve(library, "ASurfaceControl_release", api.release);
+            Resolve(library, "ASurfaceTransaction_create", api.transactionCreate);
+            Resolve(library, "ASurfaceTransaction_delete", api.transactionDelete);
+            Resolve(library, "ASurfaceTransaction_apply", api.transactionApply);
+            Resolve(library, "ASurfaceTransaction_setVisibility", api.setVisibility);
+            Resolve(library, "ASurfaceTransaction_setZOrder", api.setZOrder);
+            Resolve(library, "ASurfaceTransaction_setBufferAlpha", api.setBufferAlpha);
+            Resolve(library, "ASurfaceTransaction_reparent", api.reparent);
+            Resolve(library, "ASurfaceTransaction_setBufferTransparency", api.setBufferTransparency);
+            Resolve(library, "ASurfaceTransaction_setPosition", api.setPosition);
+            Resolve(library, "ASurfaceTransaction_setScale", api.setScale);
+            Resolve(library, "ASurfaceTransaction_setCrop", api.setCrop);
+            Resolve(library, "ASurfaceTransaction_setFrameRate", api.setFrameRate);
+
+            // Both libraries stay loaded for the process lifetime, the handles are not closed.
+            return api;
+        }
+
+        template <typename function_t>
+        static void Resolve(void *library, const char *name, function_t &function)
+        {
+            function = reinterpret_cast<function_t>(dlsym(library, name));
+        }
+
+        inline static std::atomic<const SurfaceControlApi *> s_override{nullptr};
+    };
+
+    // One native transaction, applied explicitly. Applying empties it, so it can be filled
+    // again for the next update. Calls are no-ops when creation failed.
+    class Transaction
+    {
+    public:
+        explicit Transaction(const SurfaceControlApi &api)
+            : m_api(api), m_transaction(api.transactionCreate ? api.transactionCreate() : nullptr)
+        {
+        }
+
+        ~Transaction()
+        {
+            if (m_transaction)
+                m_api.transactionDelete(m_transaction);
+        }
+
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+
+        Transaction &SetVisible(ASurfaceControl *surfaceControl, bool visible)
+        {
+            if (m_transaction && surfaceControl)
+                m_api.setVisibility(m_transaction, surfaceControl, visible ? 1 : 0);
+            return *this;
+        }
+
+        Transaction &SetLayer(ASurfaceControl *surfaceControl, int32_t z)
+        {
+            if (m_transaction && surfaceControl)
+                m_api.setZOrder(m_transaction, surfaceControl, z);
+            return *this;
+        }
+
+        Transaction &SetAlpha(ASurfaceControl *surfaceControl, float alpha)
+        {
+            if (m_transaction && surfaceControl)
+                m_api.setBufferAlpha(m_transaction, surfaceControl, alpha);
+            return *this;
+        }
+
+        Transaction &SetPosition(ASurfaceControl *surfaceControl, int32_t x, int32_t y)
+        {
+            if (m_transaction && surfaceControl && m_api.setPosition)
+                m_api.setPosition(m_transaction, surfaceControl, x, y);
+            return *this;
+        }
+
+        Transaction &SetScale(ASurfaceControl *surfaceControl, float scaleX, float scaleY)
+        {
+            if (m_transaction && surfaceControl && m_api.setScale)
+                m_api.setScale(m_transaction, surfaceControl, scaleX, scaleY);
+            return *this;
+        }
+
+        // An empty crop (all zero) removes it.
+        Transaction &SetCrop(ASurfaceControl *surfaceControl, const Rect &crop)
+        {
+            if (m_transaction && surfaceControl && m_api.setCrop)
+                m_api.setCrop(m_transaction, surfaceControl, crop);
+            return *this;
+        }
+
+        // Opaque buffers are never blended with what is below, the alpha channel is ignored.
+        Transaction &SetOpaque(ASurfaceControl *surfaceControl, bool opaque)
+        {
+            // ASURFACE_TRANSACTION_TRANSPARENCY_OPAQUE / _TRANSLUCENT
+            if (m_transaction && surfaceControl && m_api.setBufferTransparency)
+                m_api.setBufferTransparency(m_transaction, surfaceControl, opaque ? 2 : 1);
+            return *this;
+        }
+
+        // The rate the layer's content changes at, 0 withdraws the vote.
+        Transaction &SetFrameRate(ASurfaceControl *surfaceControl, float frameRate)
+        {
+            if (m_transaction && surfaceControl && m_api.setFrameRate)
+                m_api.setFrameRate(m_transaction, surfaceControl, frameRate, 0 /* ANATIVEWINDOW_FRAME_RATE_COMPATIBILITY_DEFAULT */);
+            return *this;
+        }
+
+        // Detaches the layer from its parent, which removes it from the screen.
+        Transaction &Remove(ASurfaceControl *surfaceControl)
+        {
+            if (m_transaction && surfaceControl)
+                m_api.reparent(m_transaction, surfaceControl, nullptr);
+            return *this;
+        }
+
+        void Apply()
+        {
+            if (m_transaction)
+                m_api.transactionApply(m_transaction);
+        }
+
+        inline bool IsValid() const { return m_transaction != nullptr; }
+
+    private:
+        const SurfaceControlApi &m_api;
+        ASurfaceTransaction *m_transaction;
+    };
+
+} // namespace android::anwcreator::native
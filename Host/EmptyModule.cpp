@@ -0,0 +1,5 @@
+// Loaded and unloaded by ProjectModuleCheck, the registry has to notice both.
+extern "C" __attribute__((visibility("default"))) int EmptyModuleMarker()
+{
+    return 1;
+}
@@ -0,0 +1,1059 @@
+#include "FakeJni.hpp"
+
+#include <android/log.h>
+#include <android/native_window_jni.h>
+#include <sys/system_properties.h>
+
+#include <climits>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace android::fakejni::detail
+{
+    struct Class;
+    struct Env;
+
+    // A Java object. Freed when the last reference to it goes away, framework singletons
+    // (Activity, Display, ...) hold one extra reference for the lifetime of the VM.
+    struct Object
+    {
+        Class *cls = nullptr;
+        int32_t refs = 0;
+        std::string text; // String content, SurfaceControl/Builder name
+        jint ints[4] = {}; // fields, buffer sizes and flags, Rect edges
+        jfloat floats[2] = {};
+        uint32_t operations = 0; // Transaction setters since the last apply
+    };
+
+    enum class RefKind
+    {
+        Local,
+        Global,
+    };
+
+    struct Ref : _jclass
+    {
+        Object *object;
+        RefKind kind;
+        int32_t frame;
+    };
+
+    using Invoke = jvalue (*)(Env &env, Object *self, va_list args);
+
+} // namespace android::fakejni::detail
+
+struct _jmethodID
+{
+    android::fakejni::detail::Class *owner;
+    std::string name;
+    std::string sig;
+    bool isStatic;
+    android::fakejni::detail::Invoke invoke;
+};
+
+struct _jfieldID
+{
+    android::fakejni::detail::Class *owner;
+    std::string name;
+    std::string sig;
+    int32_t slot; // into Object::ints or Object::floats, depending on sig
+};
+
+struct ANativeWindow
+{
+    int32_t refs;
+    int32_t width;
+    int32_t height;
+    int32_t transform;
+};
+
+namespace android::fakejni::detail
+{
+    struct Class
+    {
+        std::string name;
+        Object object; // what FindClass hands out a reference to
+        std::vector<std::unique_ptr<_jmethodID>> methods;
+        std::vector<std::unique_ptr<_jfieldID>> fields;
+    };
+
+    [[noreturn]] void Fatal(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        fprintf(stderr, "fakejni: JNI DETECTED ERROR IN APPLICATION: ");
+        vfprintf(stderr, format, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+        abort();
+    }
+
+    struct Env : _JNIEnv
+    {
+        VirtualMachine::State *vm = nullptr;
+        std::unordered_set<Ref *> locals;
+        int32_t frame = 0;
+        std::string exception;
+        bool attached = false;
+
+        Counters &GetCounters();
+        const Config &GetConfig();
+
+        void Count(Function function) { ++GetCounters().calls[function]; }
+
+        // Functions other than the exception and reference ones may not run with an exception pending.
+        void CheckNoException(const char *function)
+        {
+            if (!exception.empty())
+                Fatal("%s called with %s pending", function, exception.c_str());
+        }
+
+        void Throw(const std::string &name, const std::string &message)
+        {
+            if (exception.empty())
+            {
+                exception = name + ": " + message;
+                ++GetCounters().exceptionsThrown;
+            }
+        }
+
+        jobject NewLocal(Object *object)
+        {
+            if (!object)
+                return nullptr;
+
+            Ref *ref = new Ref;
+            ref->object = object;
+            ref->kind = RefKind::Local;
+            ref->frame = frame;
+            ++object->refs;
+            locals.insert(ref);
+            ++GetCounters().localRefsCreated;
+            ++GetCounters().localRefs;
+            return ref;
+        }
+
+        void DeleteLocal(Ref *ref);
+
+        Ref *Resolve(jobject obj, const char *function);
+
+        Object *ResolveObject(jobject obj, const char *function)
+        {
+            Ref *ref = Resolve(obj, function);
+            return ref ? ref->object : nullptr;
+        }
+
+        Object *Allocate(Class *cls);
+        void Release(Object *object);
+    };
+
+} // namespace android::fakejni::detail
+
+namespace android::fakejni
+{
+    using namespace detail;
+
+    struct VirtualMachine::State : _JavaVM
+    {
+        Config config;
+        Counters counters;
+        std::thread::id thread = std::this_thread::get_id();
+
+        std::unordered_map<std::string, std::unique_ptr<Class>> classes;
+        std::unordered_set<Ref *> globals;
+        Env env;
+
+        Object *activity = nullptr;
+        Object *windowManager = nullptr;
+        Object *display = nullptr;
+        Object *window = nullptr;
+        Object *decorView = nullptr;
+        Object *viewRootImpl = nullptr;
+        Object *parentSurfaceControl = nullptr;
+
+        ANativeActivity nativeActivity{};
+
+        Class *Define(const char *name)
+        {
+            auto &cls = classes[name];
+            cls = std::make_unique<Class>();
+            cls->name = name;
+            cls->object.refs = 1;
+            return cls.get();
+        }
+
+        Class *FindClass(const std::string &name)
+        {
+            auto it = classes.find(name);
+            return it == classes.end() ? nullptr : it->second.get();
+        }
+
+        void Method(Class *cls, const char *name, const char *sig, Invoke invoke, int32_t minApi = 0, int32_t maxApi = INT_MAX, bool isStatic = false)
+        {
+            if (config.apiLevel < minApi || config.apiLevel > maxApi)
+                return;
+            cls->methods.push_back(std::unique_ptr<_jmethodID>(new _jmethodID{cls, name, sig, isStatic, invoke}));
+        }
+
+        void Field(Class *cls, const char *name, const char *sig, int32_t slot)
+        {
+            cls->fields.push_back(std::unique_ptr<_jfieldID>(new _jfieldID{cls, name, sig, slot}));
+        }
+
+        Object *Singleton(Class *cls)
+        {
+            Object *object = env.Allocate(cls);
+            object->refs = 1;
+            return object;
+        }
+
+        void Build();
+    };
+
+} // namespace android::fakejni
+
+namespace android::fakejni::detail
+{
+    namespace
+    {
+        VirtualMachine::State *g_vm = nullptr;
+
+        constexpr const char *kFunctionNames[FunctionCount] = {
+            "FindClass",
+            "GetMethodID",
+            "GetStaticMethodID",
+            "GetFieldID",
+            "NewObject",
+            "CallObjectMethod",
+            "CallVoidMethod",
+            "CallIntMethod",
+            "CallFloatMethod",
+            "CallStaticVoidMethod",
+            "GetIntField",
+            "GetFloatField",
+            "NewStringUTF",
+            "NewGlobalRef",
+            "DeleteGlobalRef",
+            "NewLocalRef",
+            "DeleteLocalRef",
+            "PushLocalFrame",
+            "PopLocalFrame",
+            "ExceptionCheck",
+            "ExceptionDescribe",
+            "ExceptionClear",
+            "GetJavaVM",
+            "AttachCurrentThread",
+            "DetachCurrentThread",
+            "GetEnv",
+        };
+
+        Env &ToEnv(_JNIEnv *env)
+        {
+            Env &result = *static_cast<Env *>(env);
+            if (std::this_thread::get_id() != result.vm->thread)
+                Fatal("the fake VM is single threaded");
+            if (!result.attached)
+                Fatal("JNIEnv used after DetachCurrentThread");
+            return result;
+        }
+
+        jvalue Void()
+        {
+            jvalue value;
+            value.j = 0;
+            return value;
+        }
+
+        jvalue Int(jint i)
+        {
+            jvalue value;
+            value.i = i;
+            return value;
+        }
+
+        jvalue Float(jfloat f)
+        {
+            jvalue value;
+            value.f = f;
+            return value;
+        }
+
+        jvalue Local(Env &env, Object *object)
+        {
+            jvalue value;
+            value.l = env.NewLocal(object);
+            return value;
+        }
+
+        // First argument of the SurfaceControl.Transaction setters, null is an NPE like in Java.
+        bool TakeSurfaceControl(Env &env, va_list args, Object **out = nullptr)
+        {
+            Object *surfaceControl = env.ResolveObject(va_arg(args, jobject), "SurfaceControl argument");
+            if (!surfaceControl)
+            {
+                env.Throw("java/lang/NullPointerException", "SurfaceControl is null");
+                return false;
+            }
+            if (surfaceControl->cls->name != "android/view/SurfaceControl")
+                Fatal("expected a SurfaceControl, got %s", surfaceControl->cls->name.c_str());
+            if (out)
+                *out = surfaceControl;
+            return true;
+        }
+
+        jvalue TransactionSetter(Env &env, Object *self, va_list args)
+        {
+            if (!TakeSurfaceControl(env, args))
+                return Local(env, nullptr);
+            ++self->operations;
+            return Local(env, self);
+        }
+
+        _jmethodID *FindMethod(Class *cls, const char *name, const char *sig, bool isStatic)
+        {
+            for (auto &method : cls->methods)
+                if (method->isStatic == isStatic && method->name == name && method->sig == sig)
+                    return method.get();
+            return nullptr;
+        }
+
+        Class *ResolveClass(Env &env, jclass cls, const char *function)
+        {
+            Object *object = env.ResolveObject(cls, function);
+            if (!object)
+                Fatal("%s called with a null jclass", function);
+
+            for (auto &entry : env.vm->classes)
+                if (&entry.second->object == object)
+                    return entry.second.get();
+            Fatal("%s called with an object that is not a class", function);
+        }
+
+        // Checks the receiver and the return type against the call, like CheckJNI.
+        Object *CheckCall(Env &env, jobject obj, jmethodID method, char returnType, const char *function)
+        {
+            env.CheckNoException(function);
+            if (!method)
+                Fatal("%s called with a null jmethodID", function);
+            if (method->isStatic)
+                Fatal("%s called with static method %s", function, method->name.c_str());
+            if (method->sig.back() != returnType && !(returnType == 'L' && method->sig[method->sig.find(')') + 1] == 'L'))
+                Fatal("%s called for %s%s", function, method->name.c_str(), method->sig.c_str());
+
+            Object *self = env.ResolveObject(obj, function);
+            if (!self)
+                Fatal("%s called on a null object", function);
+            if (self->cls != method->owner)
+                Fatal("%s: %s is not a method of %s", function, method->name.c_str(), self->cls->name.c_str());
+            return self;
+        }
+
+    } // namespace
+
+    Counters &Env::GetCounters() { return vm->counters; }
+    const Config &Env::GetConfig() { return vm->config; }
+
+    Ref *Env::Resolve(jobject obj, const char *function)
+    {
+        if (!obj)
+            return nullptr;
+
+        Ref *ref = static_cast<Ref *>(obj);
+        if (!locals.count(ref) && !vm->globals.count(ref))
+            Fatal("%s used an invalid (deleted or foreign) reference %p", function, static_cast<void *>(obj));
+        return ref;
+    }
+
+    void Env::DeleteLocal(Ref *ref)
+    {
+        locals.erase(ref);
+        ++GetCounters().localRefsDeleted;
+        --GetCounters().localRefs;
+        Release(ref->object);
+        delete ref;
+    }
+
+    Object *Env::Allocate(Class *cls)
+    {
+        Object *object = new Object;
+        object->cls = cls;
+        ++GetCounters().objectsAllocated;
+        ++GetCounters().objects;
+        return object;
+    }
+
+    void Env::Release(Object *object)
+    {
+        if (--object->refs > 0 || object->cls == nullptr)
+            return;
+        --GetCounters().objects;
+        delete object;
+    }
+
+} // namespace android::fakejni::detail
+
+namespace android::fakejni
+{
+    void VirtualMachine::State::Build()
+    {
+        Class *string = Define("java/lang/String");
+        Class *activityClass = Define("android/app/Activity");
+        Class *windowManagerClass = Define("android/view/WindowManager");
+        Class *displayClass = Define("android/view/Display");
+        Class *displayMetrics = Define("android/util/DisplayMetrics");
+        Class *windowClass = Define("android/view/Window");
+        Class *view = Define("android/view/View");
+        Class *viewRootImplClass = Define("android/view/ViewRootImpl");
+        Class *surfaceControl = Define("android/view/SurfaceControl");
+        Class *builder = Define("android/view/SurfaceControl$Builder");
+        Class *transaction = Define("android/view/SurfaceControl$Transaction");
+        Class *surface = Define("android/view/Surface");
+        Class *rect = Define("android/graphics/Rect");
+        (void)string;
+
+        Method(activityClass, "getWindowManager", "()Landroid/view/WindowManager;",
+               [](Env &env, Object *, va_list) { return Local(env, env.vm->windowManager); });
+        Method(activityClass, "getWindow", "()Landroid/view/Window;",
+               [](Env &env, Object *, va_list) { return Local(env, env.vm->window); });
+        Method(windowManagerClass, "getDefaultDisplay", "()Landroid/view/Display;",
+               [](Env &env, Object *, va_list) { return Local(env, env.vm->display); });
+
+        Method(displayClass, "getRealMetrics", "(Landroid/util/DisplayMetrics;)V",
+               [](Env &env, Object *, va_list args)
+               {
+                   Object *metrics = env.ResolveObject(va_arg(args, jobject), "getRealMetrics");
+                   if (!metrics)
+                   {
+                       env.Throw("java/lang/NullPointerException", "outMetrics is null");
+                       return Void();
+                   }
+                   metrics->ints[0] = env.GetConfig().displayWidth;
+                   metrics->ints[1] = env.GetConfig().displayHeight;
+                   metrics->ints[2] = env.GetConfig().densityDpi;
+                   metrics->floats[0] = env.GetConfig().density;
+                   return Void();
+               });
+        Method(displayClass, "getRotation", "()I",
+               [](Env &env, Object *, va_list) { return Int(env.GetConfig().rotation); });
+        Method(displayClass, "getRefreshRate", "()F",
+               [](Env &env, Object *, va_list) { return Float(env.GetConfig().refreshRate); });
+
+        Method(displayMetrics, "<init>", "()V", [](Env &, Object *, va_list) { return Void(); });
+        Field(displayMetrics, "widthPixels", "I", 0);
+        Field(displayMetrics, "heightPixels", "I", 1);
+        Field(displayMetrics, "densityDpi", "I", 2);
+        Field(displayMetrics, "density", "F", 0);
+
+        Method(windowClass, "getDecorView", "()Landroid/view/View;",
+               [](Env &env, Object *, va_list) { return Local(env, env.vm->decorView); });
+        Method(view, "getViewRootImpl", "()Landroid/view/ViewRootImpl;",
+               [](Env &env, Object *, va_list) { return Local(env, env.vm->viewRootImpl); });
+        Method(viewRootImplClass, "getSurfaceControl", "()Landroid/view/SurfaceControl;",
+               [](Env &env, Object *, va_list) { return Local(env, env.vm->parentSurfaceControl); });
+
+        Method(builder, "<init>", "()V", [](Env &, Object *, va_list) { return Void(); });
+        Method(builder, "setName", "(Ljava/lang/String;)Landroid/view/SurfaceControl$Builder;",
+               [](Env &env, Object *self, va_list args)
+               {
+                   Object *name = env.ResolveObject(va_arg(args, jobject), "Builder.setName");
+                   if (!name)
+                   {
+                       env.Throw("java/lang/IllegalArgumentException", "name must not be null");
+                       return Local(env, nullptr);
+                   }
+                   self->text = name->text;
+                   self->ints[3] = 1;
+                   return Local(env, self);
+               });
+        Method(builder, "setParent", "(Landroid/view/SurfaceControl;)Landroid/view/SurfaceControl$Builder;",
+               [](Env &env, Object *self, va_list args)
+               {
+                   env.ResolveObject(va_arg(args, jobject), "Builder.setParent");
+                   return Local(env, self);
+               });
+        Method(builder, "setBufferSize", "(II)Landroid/view/SurfaceControl$Builder;",
+               [](Env &env, Object *self, va_list args)
+               {
+                   self->ints[0] = va_arg(args, jint);
+                   self->ints[1] = va_arg(args, jint);
+                   return Local(env, self);
+               });
+        Method(builder, "setFlags", "(II)Landroid/view/SurfaceControl$Builder;",
+               [](Env &env, Object *self, va_list args)
+               {
+                   jint flags = va_arg(args, jint);
+                   jint mask = va_arg(args, jint);
+                   self->ints[2] = (self->ints[2] & ~mask) | (flags & mask);
+                   return Local(env, self);
+               });
+        Method(builder, "build", "()Landroid/view/SurfaceControl;",
+               [](Env &env, Object *self, va_list)
+               {
+                   if (!self->ints[3])
+                   {
+                       env.Throw("java/lang/IllegalStateException", "name must not be null");
+                       return Local(env, nullptr);
+                   }
+                   Object *result = env.Allocate(env.vm->FindClass("android/view/SurfaceControl"));
+                   result->text = self->text;
+                   result->ints[0] = self->ints[0];
+                   result->ints[1] = self->ints[1];
+                   return Local(env, result);
+               });
+
+        constexpr const char *kSetterSuffix = "Landroid/view/SurfaceControl$Transaction;";
+        std::string sig;
+        Method(transaction, "<init>", "()V", [](Env &, Object *, va_list) { return Void(); });
+        Method(transaction, "setAlpha", (sig = "(Landroid/view/SurfaceControl;F)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "setLayer", (sig = "(Landroid/view/SurfaceControl;I)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "setPosition", (sig = "(Landroid/view/SurfaceControl;FF)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "setBufferSize", (sig = "(Landroid/view/SurfaceControl;II)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "setScale", (sig = "(Landroid/view/SurfaceControl;FF)").append(kSetterSuffix).c_str(), TransactionSetter, 31);
+        Method(transaction, "setMatrix", (sig = "(Landroid/view/SurfaceControl;FFFF)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "setCrop", (sig = "(Landroid/view/SurfaceControl;Landroid/graphics/Rect;)").append(kSetterSuffix).c_str(),
+               [](Env &env, Object *self, va_list args)
+               {
+                   if (!TakeSurfaceControl(env, args))
+                       return Local(env, nullptr);
+                   env.ResolveObject(va_arg(args, jobject), "Transaction.setCrop");
+                   ++self->operations;
+                   return Local(env, self);
+               }, 29);
+        Method(transaction, "setFrameRate", (sig = "(Landroid/view/SurfaceControl;FI)").append(kSetterSuffix).c_str(), TransactionSetter, 30);
+        Method(transaction, "setOpaque", (sig = "(Landroid/view/SurfaceControl;Z)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "show", (sig = "(Landroid/view/SurfaceControl;)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "hide", (sig = "(Landroid/view/SurfaceControl;)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "remove", (sig = "(Landroid/view/SurfaceControl;)").append(kSetterSuffix).c_str(), TransactionSetter);
+        Method(transaction, "apply", "()V",
+               [](Env &env, Object *self, va_list)
+               {
+                   ++env.GetCounters().transactionsApplied;
+                   env.GetCounters().transactionOperations += self->operations;
+                   self->operations = 0;
+                   return Void();
+               });
+        Method(transaction, "sync", "()V", [](Env &, Object *, va_list) { return Void(); }, 0, 29, true);
+
+        Method(surface, "<init>", "(Landroid/view/SurfaceControl;)V",
+               [](Env &env, Object *self, va_list args)
+               {
+                   Object *source = nullptr;
+                   if (TakeSurfaceControl(env, args, &source))
+                   {
+                       self->ints[0] = source->ints[0];
+                       self->ints[1] = source->ints[1];
+                   }
+                   return Void();
+               });
+
+        Method(rect, "<init>", "(IIII)V",
+               [](Env &, Object *self, va_list args)
+               {
+                   for (jint &edge : self->ints)
+                       edge = va_arg(args, jint);
+                   return Void();
+               });
+
+        activity = Singleton(activityClass);
+        windowManager = Singleton(windowManagerClass);
+        display = Singleton(displayClass);
+        window = Singleton(windowClass);
+        decorView = Singleton(view);
+        viewRootImpl = Singleton(viewRootImplClass);
+        parentSurfaceControl = Singleton(surfaceControl);
+        parentSurfaceControl->text = "ViewRootImpl";
+    }
+
+    VirtualMachine::VirtualMachine(const Config &config) : m_state(std::make_unique<State>())
+    {
+        if (g_vm)
+            Fatal("only one fake VM can exist at a time");
+        g_vm = m_state.get();
+
+        State &state = *m_state;
+        state.config = config;
+        state.env.vm = &state;
+        state.env.attached = true; // the creating thread plays the main thread
+        state.Build();
+
+        state.nativeActivity.vm = &state;
+        state.nativeActivity.env = &state.env;
+        state.nativeActivity.sdkVersion = config.apiLevel;
+
+        jobject local = state.env.NewLocal(state.activity);
+        state.nativeActivity.clazz = state.env.NewGlobalRef(local);
+        state.env.DeleteLocalRef(local);
+
+        ResetCounters();
+    }
+
+    VirtualMachine::~VirtualMachine()
+    {
+        State &state = *m_state;
+        for (Ref *ref : state.env.locals)
+            delete ref;
+        for (Ref *ref : state.globals)
+            delete ref;
+        g_vm = nullptr;
+    }
+
+    ANativeActivity *VirtualMachine::GetActivity() { return &m_state->nativeActivity; }
+    JavaVM *VirtualMachine::GetJavaVM() { return m_state.get(); }
+    const Counters &VirtualMachine::GetCounters() const { return m_state->counters; }
+
+    void VirtualMachine::SetRotation(int32_t rotation)
+    {
+        Config &config = m_state->config;
+        if ((rotation ^ config.rotation) & 1)
+        {
+            int32_t width = config.displayWidth;
+            config.displayWidth = config.displayHeight;
+            config.displayHeight = width;
+        }
+        config.rotation = rotation;
+    }
+
+    void VirtualMachine::SetRefreshRate(float refreshRate) { m_state->config.refreshRate = refreshRate; }
+
+    void VirtualMachine::ResetCounters()
+    {
+        Counters &counters = m_state->counters;
+        Counters fresh;
+        fresh.localRefs = counters.localRefs;
+        fresh.globalRefs = counters.globalRefs;
+        fresh.objects = counters.objects;
+        fresh.windows = counters.windows;
+        counters = fresh;
+    }
+
+    const char *VirtualMachine::GetFunctionName(Function function)
+    {
+        return function >= 0 && function < FunctionCount ? kFunctionNames[function] : "?";
+    }
+
+} // namespace android::fakejni
+
+using android::fakejni::Function;
+using namespace android::fakejni::detail;
+
+jclass _JNIEnv::FindClass(const char *name)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::FindClass);
+    env.CheckNoException("FindClass");
+
+    Class *cls = env.vm->FindClass(name);
+    if (!cls)
+    {
+        env.Throw("java/lang/NoClassDefFoundError", name);
+        return nullptr;
+    }
+    return static_cast<jclass>(static_cast<Ref *>(env.NewLocal(&cls->object)));
+}
+
+jmethodID _JNIEnv::GetMethodID(jclass cls, const char *name, const char *sig)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::GetMethodID);
+    env.CheckNoException("GetMethodID");
+
+    jmethodID method = FindMethod(ResolveClass(env, cls, "GetMethodID"), name, sig, false);
+    if (!method)
+        env.Throw("java/lang/NoSuchMethodError", std::string(name) + sig);
+    return method;
+}
+
+jmethodID _JNIEnv::GetStaticMethodID(jclass cls, const char *name, const char *sig)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::GetStaticMethodID);
+    env.CheckNoException("GetStaticMethodID");
+
+    jmethodID method = FindMethod(ResolveClass(env, cls, "GetStaticMethodID"), name, sig, true);
+    if (!method)
+        env.Throw("java/lang/NoSuchMethodError", std::string(name) + sig);
+    return method;
+}
+
+jfieldID _JNIEnv::GetFieldID(jclass cls, const char *name, const char *sig)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::GetFieldID);
+    env.CheckNoException("GetFieldID");
+
+    for (auto &field : ResolveClass(env, cls, "GetFieldID")->fields)
+        if (field->name == name && field->sig == sig)
+            return field.get();
+    env.Throw("java/lang/NoSuchFieldError", name);
+    return nullptr;
+}
+
+jobject _JNIEnv::NewObject(jclass cls, jmethodID method, ...)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::NewObject);
+    env.CheckNoException("NewObject");
+
+    Class *target = ResolveClass(env, cls, "NewObject");
+    if (!method || method->owner != target || method->name != "<init>")
+        Fatal("NewObject called without a constructor of %s", target->name.c_str());
+
+    // The local ref keeps the object alive while the constructor runs.
+    jobject result = env.NewLocal(env.Allocate(target));
+    va_list args;
+    va_start(args, method);
+    method->invoke(env, static_cast<Ref *>(result)->object, args);
+    va_end(args);
+    return result;
+}
+
+jobject _JNIEnv::CallObjectMethod(jobject obj, jmethodID method, ...)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::CallObjectMethod);
+    Object *self = CheckCall(env, obj, method, 'L', "CallObjectMethod");
+
+    va_list args;
+    va_start(args, method);
+    jvalue result = method->invoke(env, self, args);
+    va_end(args);
+    return result.l;
+}
+
+void _JNIEnv::CallVoidMethod(jobject obj, jmethodID method, ...)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::CallVoidMethod);
+    Object *self = CheckCall(env, obj, method, 'V', "CallVoidMethod");
+
+    va_list args;
+    va_start(args, method);
+    method->invoke(env, self, args);
+    va_end(args);
+}
+
+jint _JNIEnv::CallIntMethod(jobject obj, jmethodID method, ...)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::CallIntMethod);
+    Object *self = CheckCall(env, obj, method, 'I', "CallIntMethod");
+
+    va_list args;
+    va_start(args, method);
+    jvalue result = method->invoke(env, self, args);
+    va_end(args);
+    return result.i;
+}
+
+jfloat _JNIEnv::CallFloatMethod(jobject obj, jmethodID method, ...)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::CallFloatMethod);
+    Object *self = CheckCall(env, obj, method, 'F', "CallFloatMethod");
+
+    va_list args;
+    va_start(args, method);
+    jvalue result = method->invoke(env, self, args);
+    va_end(args);
+    return result.f;
+}
+
+void _JNIEnv::CallStaticVoidMethod(jclass cls, jmethodID method, ...)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::CallStaticVoidMethod);
+    env.CheckNoException("CallStaticVoidMethod");
+
+    Class *target = ResolveClass(env, cls, "CallStaticVoidMethod");
+    if (!method || !method->isStatic || method->owner != target)
+        Fatal("CallStaticVoidMethod called without a static method of %s", target->name.c_str());
+
+    va_list args;
+    va_start(args, method);
+    method->invoke(env, nullptr, args);
+    va_end(args);
+}
+
+jint _JNIEnv::GetIntField(jobject obj, jfieldID field)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::GetIntField);
+    env.CheckNoException("GetIntField");
+
+    Object *self = env.ResolveObject(obj, "GetIntField");
+    if (!self || !field || self->cls != field->owner || field->sig != "I")
+        Fatal("GetIntField called with a mismatched object or field");
+    return self->ints[field->slot];
+}
+
+jfloat _JNIEnv::GetFloatField(jobject obj, jfieldID field)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::GetFloatField);
+    env.CheckNoException("GetFloatField");
+
+    Object *self = env.ResolveObject(obj, "GetFloatField");
+    if (!self || !field || self->cls != field->owner || field->sig != "F")
+        Fatal("GetFloatField called with a mismatched object or field");
+    return self->floats[field->slot];
+}
+
+jstring _JNIEnv::NewStringUTF(const char *bytes)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::NewStringUTF);
+    env.CheckNoException("NewStringUTF");
+
+    if (!bytes)
+        return nullptr;
+
+    Object *string = env.Allocate(env.vm->FindClass("java/lang/String"));
+    string->text = bytes;
+    return reinterpret_cast<jstring>(env.NewLocal(string));
+}
+
+jobject _JNIEnv::NewGlobalRef(jobject obj)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::NewGlobalRef);
+
+    Object *object = env.ResolveObject(obj, "NewGlobalRef");
+    if (!object)
+        return nullptr;
+
+    Ref *ref = new Ref;
+    ref->object = object;
+    ref->kind = RefKind::Global;
+    ref->frame = 0;
+    ++object->refs;
+    env.vm->globals.insert(ref);
+    ++env.GetCounters().globalRefsCreated;
+    ++env.GetCounters().globalRefs;
+    return ref;
+}
+
+void _JNIEnv::DeleteGlobalRef(jobject globalRef)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::DeleteGlobalRef);
+
+    if (!globalRef)
+        return;
+
+    Ref *ref = static_cast<Ref *>(globalRef);
+    if (!env.vm->globals.erase(ref))
+        Fatal("DeleteGlobalRef on a reference that is not a live global ref (%p)", static_cast<void *>(globalRef));
+
+    ++env.GetCounters().globalRefsDeleted;
+    --env.GetCounters().globalRefs;
+    env.Release(ref->object);
+    delete ref;
+}
+
+jobject _JNIEnv::NewLocalRef(jobject ref)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::NewLocalRef);
+    return env.NewLocal(env.ResolveObject(ref, "NewLocalRef"));
+}
+
+void _JNIEnv::DeleteLocalRef(jobject localRef)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::DeleteLocalRef);
+
+    if (!localRef)
+        return;
+
+    Ref *ref = static_cast<Ref *>(localRef);
+    if (!env.locals.count(ref))
+        Fatal("DeleteLocalRef on a reference that is not a live local ref (%p)", static_cast<void *>(localRef));
+    env.DeleteLocal(ref);
+}
+
+jint _JNIEnv::PushLocalFrame(jint capacity)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::PushLocalFrame);
+
+    if (capacity < 0)
+        Fatal("PushLocalFrame with negative capacity");
+    ++env.frame;
+    return JNI_OK;
+}
+
+jobject _JNIEnv::PopLocalFrame(jobject result)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::PopLocalFrame);
+
+    if (env.frame == 0)
+        Fatal("PopLocalFrame without PushLocalFrame");
+
+    Object *object = env.ResolveObject(result, "PopLocalFrame");
+    if (object)
+        ++object->refs; // survives the frame
+
+    std::vector<Ref *> dropped;
+    for (Ref *ref : env.locals)
+        if (ref->frame == env.frame)
+            dropped.push_back(ref);
+    for (Ref *ref : dropped)
+        env.DeleteLocal(ref);
+    --env.frame;
+
+    if (!object)
+        return nullptr;
+
+    jobject moved = env.NewLocal(object);
+    env.Release(object);
+    return moved;
+}
+
+jboolean _JNIEnv::ExceptionCheck()
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::ExceptionCheck);
+    return env.exception.empty() ? JNI_FALSE : JNI_TRUE;
+}
+
+void _JNIEnv::ExceptionDescribe()
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::ExceptionDescribe);
+    if (!env.exception.empty())
+        fprintf(stderr, "fakejni: pending exception %s\n", env.exception.c_str());
+}
+
+void _JNIEnv::ExceptionClear()
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::ExceptionClear);
+    env.exception.clear();
+}
+
+jint _JNIEnv::GetJavaVM(JavaVM **vm)
+{
+    Env &env = ToEnv(this);
+    env.Count(Function::GetJavaVM);
+    *vm = env.vm;
+    return JNI_OK;
+}
+
+jint _JavaVM::AttachCurrentThread(JNIEnv **env, void *)
+{
+    auto &state = *static_cast<android::fakejni::VirtualMachine::State *>(this);
+    ++state.counters.calls[Function::AttachCurrentThread];
+    if (std::this_thread::get_id() != state.thread)
+        Fatal("the fake VM is single threaded");
+
+    state.env.attached = true;
+    *env = &state.env;
+    return JNI_OK;
+}
+
+jint _JavaVM::DetachCurrentThread()
+{
+    auto &state = *static_cast<android::fakejni::VirtualMachine::State *>(this);
+    ++state.counters.calls[Function::DetachCurrentThread];
+    if (!state.env.attached)
+        return JNI_ERR;
+
+    // Detaching frees whatever local refs the thread still holds.
+    std::vector<Ref *> dropped(state.env.locals.begin(), state.env.locals.end());
+    for (Ref *ref : dropped)
+        state.env.DeleteLocal(ref);
+    state.env.frame = 0;
+    state.env.attached = false;
+    return JNI_OK;
+}
+
+jint _JavaVM::GetEnv(void **env, jint)
+{
+    auto &state = *static_cast<android::fakejni::VirtualMachine::State *>(this);
+    ++state.counters.calls[Function::GetEnv];
+
+    if (!state.env.attached || std::this_thread::get_id() != state.thread)
+    {
+        *env = nullptr;
+        return JNI_EDETACHED;
+    }
+    *env = static_cast<JNIEnv *>(&state.env);
+    return JNI_OK;
+}
+
+extern "C"
+{
+    ANativeWindow *ANativeWindow_fromSurface(JNIEnv *jniEnv, jobject surface)
+    {
+        Env &env = ToEnv(jniEnv);
+        Object *object = env.ResolveObject(surface, "ANativeWindow_fromSurface");
+        if (!object || object->cls->name != "android/view/Surface")
+            return nullptr;
+
+        ++env.GetCounters().windows;
+        return new ANativeWindow{1, object->ints[0], object->ints[1], ANATIVEWINDOW_TRANSFORM_IDENTITY};
+    }
+
+    void ANativeWindow_acquire(ANativeWindow *window)
+    {
+        ++window->refs;
+    }
+
+    void ANativeWindow_release(ANativeWindow *window)
+    {
+        if (--window->refs > 0)
+            return;
+        if (g_vm)
+            --g_vm->counters.windows;
+        delete window;
+    }
+
+    int32_t ANativeWindow_getWidth(ANativeWindow *window) { return window->width; }
+    int32_t ANativeWindow_getHeight(ANativeWindow *window) { return window->height; }
+
+    int32_t ANativeWindow_setBuffersGeometry(ANativeWindow *window, int32_t width, int32_t height, int32_t)
+    {
+        if (width > 0 && height > 0)
+        {
+            window->width = width;
+            window->height = height;
+        }
+        return 0;
+    }
+
+    int32_t ANativeWindow_setBuffersTransform(ANativeWindow *window, int32_t transform)
+    {
+        window->transform = transform;
+        return 0;
+    }
+
+    int __system_property_get(const char *name, char *value)
+    {
+        value[0] = '\0';
+        if (g_vm && 0 == strcmp(name, "ro.build.version.sdk"))
+            return snprintf(value, PROP_VALUE_MAX, "%d", g_vm->config.apiLevel);
+        return 0;
+    }
+
+    int __android_log_print(int, const char *tag, const char *fmt, ...)
+    {
+        if (!g_vm || !g_vm->config.log)
+            return 0;
+
+        va_list args;
+        va_start(args, fmt);
+        fprintf(stderr, "[%s] ", tag);
+        vfprintf(stderr, fmt, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+        return 1;
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <jni.h>
+#include <android/native_activity.h>
+
+#include <cstdint>
+#include <memory>
+
+// A JavaVM/JNIEnv stand-in for running ANwCreator on a Linux host. It models the framework
+// classes the overlay touches (Activity down to ViewRootImpl, Display, DisplayMetrics,
+// SurfaceControl and its Builder/Transaction, Surface, Rect) and counts every JNI call and
+// reference, so the JNI cost of an operation can be measured and local/global ref leaks
+// show up. Misuse that CheckJNI would abort on (stale refs, wrong ref kind) aborts here too.
+// Single threaded: one VM at a time, used from one thread.
+
+namespace android::fakejni
+{
+    enum Function : int32_t
+    {
+        FindClass,
+        GetMethodID,
+        GetStaticMethodID,
+        GetFieldID,
+        NewObject,
+        CallObjectMethod,
+        CallVoidMethod,
+        CallIntMethod,
+        CallFloatMethod,
+        CallStaticVoidMethod,
+        GetIntField,
+        GetFloatField,
+        NewStringUTF,
+        NewGlobalRef,
+        DeleteGlobalRef,
+        NewLocalRef,
+        DeleteLocalRef,
+        PushLocalFrame,
+        PopLocalFrame,
+        ExceptionCheck,
+        ExceptionDescribe,
+        ExceptionClear,
+        GetJavaVM,
+        AttachCurrentThread,
+        DetachCurrentThread,
+        GetEnv,
+        FunctionCount
+    };
+
+    struct Counters
+    {
+        uint64_t calls[FunctionCount] = {};
+
+        uint64_t localRefsCreated = 0;
+        uint64_t localRefsDeleted = 0;
+        uint64_t globalRefsCreated = 0;
+        uint64_t globalRefsDeleted = 0;
+        uint64_t objectsAllocated = 0;
+        uint64_t exceptionsThrown = 0;
+        uint64_t transactionsApplied = 0;
+        uint64_t transactionOperations = 0; // setters called on applied transactions
+
+        // Live values, not reset by ResetCounters().
+        int64_t localRefs = 0;
+        int64_t globalRefs = 0;
+        int64_t objects = 0;
+        int64_t windows = 0;
+
+        uint64_t GetTotalCalls() const
+        {
+            uint64_t total = 0;
+            for (uint64_t count : calls)
+                total += count;
+            return total;
+        }
+    };
+
+    struct Config
+    {
+        int32_t apiLevel = 34;
+        int32_t displayWidth = 2400;
+        int32_t displayHeight = 1080;
+        int32_t rotation = 1;
+        float refreshRate = 120.0f;
+        float density = 2.75f;
+        int32_t densityDpi = 440;
+        bool log = false; // print __android_log_print output
+    };
+
+    class VirtualMachine
+    {
+    public:
+        explicit VirtualMachine(const Config &config = Config());
+        ~VirtualMachine();
+
+        VirtualMachine(const VirtualMachine &) = delete;
+        VirtualMachine &operator=(const VirtualMachine &) = delete;
+
+        // vm, env and clazz (a global ref to the Activity) are filled in.
+        ANativeActivity *GetActivity();
+        JavaVM *GetJavaVM();
+
+        // What Display reports from now on. Turning by 90 or 270 degrees swaps width and height.
+        void SetRotation(int32_t rotation);
+        void SetRefreshRate(float refreshRate);
+
+        const Counters &GetCounters() const;
+        void ResetCounters();
+
+        static const char *GetFunctionName(Function function);
+
+        struct State;
+
+    private:
+        std::unique_ptr<State> m_state;
+    };
+
+} // namespace android::fakejni
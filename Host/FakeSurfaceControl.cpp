@@ -0,0 +1,185 @@
+#include "FakeSurfaceControl.hpp"
+
+#include <android/native_window.h>
+
+struct ASurfaceControl
+{
+    void *javaObject;
+};
+
+struct ASurfaceTransaction
+{
+    uint32_t operations; // setters since the last apply
+};
+
+namespace android::fakesurfacecontrol
+{
+    namespace
+    {
+        Counters g_counters;
+        Staged g_staged;
+
+        void Count(Function function, ASurfaceTransaction *transaction = nullptr)
+        {
+            ++g_counters.calls[function];
+            if (transaction)
+                ++transaction->operations;
+        }
+
+        ASurfaceControl *FromJavaImpl(void *, void *surfaceControl)
+        {
+            Count(FromJava);
+            ++g_counters.surfaceControls;
+            return new ASurfaceControl{surfaceControl};
+        }
+
+        void ReleaseImpl(ASurfaceControl *surfaceControl)
+        {
+            Count(Release);
+            --g_counters.surfaceControls;
+            delete surfaceControl;
+        }
+
+        ASurfaceTransaction *TransactionCreateImpl()
+        {
+            Count(TransactionCreate);
+            ++g_counters.transactions;
+            return new ASurfaceTransaction{0};
+        }
+
+        void TransactionDeleteImpl(ASurfaceTransaction *transaction)
+        {
+            Count(TransactionDelete);
+            --g_counters.transactions;
+            delete transaction;
+        }
+
+        void TransactionApplyImpl(ASurfaceTransaction *transaction)
+        {
+            Count(TransactionApply);
+            if (!transaction->operations)
+                ++g_counters.emptyApplies;
+            transaction->operations = 0;
+        }
+
+        void SetVisibilityImpl(ASurfaceTransaction *transaction, ASurfaceControl *, int8_t visibility)
+        {
+            Count(SetVisibility, transaction);
+            g_staged.visible = visibility != 0;
+        }
+
+        void SetZOrderImpl(ASurfaceTransaction *transaction, ASurfaceControl *, int32_t z)
+        {
+            Count(SetZOrder, transaction);
+            g_staged.z = z;
+        }
+
+        void SetBufferAlphaImpl(ASurfaceTransaction *transaction, ASurfaceControl *, float alpha)
+        {
+            Count(SetBufferAlpha, transaction);
+            g_staged.alpha = alpha;
+        }
+
+        void ReparentImpl(ASurfaceTransaction *transaction, ASurfaceControl *, ASurfaceControl *newParent)
+        {
+            Count(Reparent, transaction);
+            g_staged.parent = newParent;
+        }
+
+        void SetBufferTransparencyImpl(ASurfaceTransaction *transaction, ASurfaceControl *, int8_t transparency)
+        {
+            Count(SetBufferTransparency, transaction);
+            g_staged.transparency = transparency;
+        }
+
+        void SetPositionImpl(ASurfaceTransaction *transaction, ASurfaceControl *, int32_t x, int32_t y)
+        {
+            Count(SetPosition, transaction);
+            g_staged.x = x;
+            g_staged.y = y;
+        }
+
+        void SetScaleImpl(ASurfaceTransaction *transaction, ASurfaceControl *, float xScale, float yScale)
+        {
+            Count(SetScale, transaction);
+            g_staged.scaleX = xScale;
+            g_staged.scaleY = yScale;
+        }
+
+        void SetCropImpl(ASurfaceTransaction *transaction, ASurfaceControl *, const anwcreator::native::Rect &crop)
+        {
+            Count(SetCrop, transaction);
+            g_staged.crop = crop;
+        }
+
+        void SetFrameRateImpl(ASurfaceTransaction *transaction, ASurfaceControl *, float frameRate, int8_t)
+        {
+            Count(SetFrameRate, transaction);
+            g_staged.frameRate = frameRate;
+        }
+
+        // The transform still reaches the fake window, like the system one would.
+        int32_t SetBuffersTransformImpl(ANativeWindow *window, int32_t transform)
+        {
+            Count(SetBuffersTransform);
+            g_staged.transform = transform;
+            return ANativeWindow_setBuffersTransform(window, transform);
+        }
+
+        anwcreator::native::SurfaceControlApi MakeApi()
+        {
+            anwcreator::native::SurfaceControlApi api;
+            api.fromJava = FromJavaImpl;
+            api.release = ReleaseImpl;
+            api.transactionCreate = TransactionCreateImpl;
+            api.transactionDelete = TransactionDeleteImpl;
+            api.transactionApply = TransactionApplyImpl;
+            api.setVisibility = SetVisibilityImpl;
+            api.setZOrder = SetZOrderImpl;
+            api.setBufferAlpha = SetBufferAlphaImpl;
+            api.reparent = ReparentImpl;
+            api.setBufferTransparency = SetBufferTransparencyImpl;
+            api.setPosition = SetPositionImpl;
+            api.setScale = SetScaleImpl;
+            api.setCrop = SetCropImpl;
+            api.setFrameRate = SetFrameRateImpl;
+            api.setBuffersTransform = SetBuffersTransformImpl;
+            return api;
+        }
+    }
+
+    const anwcreator::native::SurfaceControlApi &GetApi()
+    {
+        static const anwcreator::native::SurfaceControlApi api = MakeApi();
+        return api;
+    }
+
+    const Counters &GetCounters()
+    {
+        return g_counters;
+    }
+
+    const Staged &GetStaged()
+    {
+        return g_staged;
+    }
+
+    void ResetCounters()
+    {
+        for (uint64_t &count : g_counters.calls)
+            count = 0;
+        g_counters.emptyApplies = 0;
+        g_staged = Staged();
+    }
+
+    const char *GetFunctionName(Function function)
+    {
+        static const char *const names[FunctionCount] = {
+            "fromJava", "release", "transactionCreate", "transactionDelete", "transactionApply",
+            "setVisibility", "setZOrder", "setBufferAlpha", "reparent", "setBufferTransparency",
+            "setPosition", "setScale", "setCrop", "setFrameRate", "setBuffersTransform",
+        };
+        return function >= 0 && function < FunctionCount ? names[function] : "?";
+    }
+
+} // namespace android::fakesurfacecontrol
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../Header/SurfaceControlApi.hpp"
+
+#include <cstdint>
+
+// A SurfaceControlApi table for running the NDK path of ANwCreator on a Linux host. Every
+// entry point is counted and the values staged through it are recorded, so a test can
+// check which properties a transaction carried. Layers and transactions are tracked, one
+// left alive after the overlay is gone is a leak. Single threaded, like Host/FakeJni.
+
+namespace android::fakesurfacecontrol
+{
+    enum Function : int32_t
+    {
+        FromJava,
+        Release,
+        TransactionCreate,
+        TransactionDelete,
+        TransactionApply,
+        SetVisibility,
+        SetZOrder,
+        SetBufferAlpha,
+        Reparent,
+        SetBufferTransparency,
+        SetPosition,
+        SetScale,
+        SetCrop,
+        SetFrameRate,
+        SetBuffersTransform,
+        FunctionCount
+    };
+
+    struct Counters
+    {
+        uint64_t calls[FunctionCount] = {};
+        uint64_t emptyApplies = 0; // transactions applied without a single setter
+
+        // Live values, not reset by ResetCounters().
+        int64_t surfaceControls = 0;
+        int64_t transactions = 0;
+
+        // Setters called on transactions, applied or not.
+        uint64_t GetSetterCalls() const
+        {
+            uint64_t total = 0;
+            for (int32_t i = SetVisibility; i <= SetFrameRate; ++i)
+                total += calls[i];
+            return total;
+        }
+    };
+
+    // The last value each setter was called with.
+    struct Staged
+    {
+        bool visible = false;
+        int32_t z = 0;
+        float alpha = 0.0f;
+        ASurfaceControl *parent = nullptr;
+        int8_t transparency = 0;
+        int32_t x = 0;
+        int32_t y = 0;
+        float scaleX = 0.0f;
+        float scaleY = 0.0f;
+        anwcreator::native::Rect crop;
+        float frameRate = 0.0f;
+        int32_t transform = 0;
+    };
+
+    // Every entry point set, HasGeometry() and IsValid() are true.
+    const anwcreator::native::SurfaceControlApi &GetApi();
+
+    const Counters &GetCounters();
+    const Staged &GetStaged();
+    void ResetCounters();
+
+    const char *GetFunctionName(Function function);
+
+} // namespace android::fakesurfacecontrol
@@ -0,0 +1,174 @@
+#include "GlCallCounter.hpp"
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <dlfcn.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace android::glcounter::detail
+{
+    enum Kind
+    {
+        Call,
+        Query,
+        Draw
+    };
+
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> queries{0};
+    std::atomic<uint64_t> draws{0};
+
+    void Count(Kind kind)
+    {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        if (Query == kind)
+            queries.fetch_add(1, std::memory_order_relaxed);
+        else if (Draw == kind)
+            draws.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // With every GL symbol defined here the linker may drop the GLES library (--as-needed),
+    // then RTLD_NEXT finds nothing and the library is opened by name.
+    void *Resolve(const char *name)
+    {
+        void *function = dlsym(RTLD_NEXT, name);
+        if (!function)
+        {
+            static void *library = dlopen("libGLESv2.so.2", RTLD_NOW | RTLD_LOCAL);
+            function = library ? dlsym(library, name) : nullptr;
+        }
+        if (!function)
+        {
+            fprintf(stderr, "GlCallCounter: %s not found in the GL library\n", name);
+            abort();
+        }
+        return function;
+    }
+
+    using DrawElementsBaseVertexProc = void (*)(GLenum, GLsizei, GLenum, const void *, GLint);
+    std::atomic<DrawElementsBaseVertexProc> drawElementsBaseVertex{nullptr};
+
+    void CountedDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void *indices, GLint baseVertex)
+    {
+        Count(Draw);
+        drawElementsBaseVertex.load(std::memory_order_relaxed)(mode, count, type, indices, baseVertex);
+    }
+} // namespace android::glcounter::detail
+
+namespace android::glcounter
+{
+    Counters GetCounters()
+    {
+        Counters counters;
+        counters.calls = detail::calls.load(std::memory_order_relaxed);
+        counters.queries = detail::queries.load(std::memory_order_relaxed);
+        counters.draws = detail::draws.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+    void ResetCounters()
+    {
+        detail::calls.store(0, std::memory_order_relaxed);
+        detail::queries.store(0, std::memory_order_relaxed);
+        detail::draws.store(0, std::memory_order_relaxed);
+    }
+} // namespace android::glcounter
+
+// Defines `name` with the driver's signature: count, then call the real entry point.
+#define GL_COUNTED(kind, ret, name, params, args)                                                             \
+    extern "C" ret name params                                                                               \
+    {                                                                                                        \
+        static const auto real = reinterpret_cast<ret(*) params>(android::glcounter::detail::Resolve(#name)); \
+        android::glcounter::detail::Count(android::glcounter::detail::kind);                                \
+        return real args;                                                                                    \
+    }
+
+GL_COUNTED(Call, void, glActiveTexture, (GLenum texture), (texture))
+GL_COUNTED(Call, void, glAttachShader, (GLuint program, GLuint shader), (program, shader))
+GL_COUNTED(Call, void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer))
+GL_COUNTED(Call, void, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer))
+GL_COUNTED(Call, void, glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer))
+GL_COUNTED(Call, void, glBindSampler, (GLuint unit, GLuint sampler), (unit, sampler))
+GL_COUNTED(Call, void, glBindTexture, (GLenum target, GLuint texture), (target, texture))
+GL_COUNTED(Call, void, glBindVertexArray, (GLuint array), (array))
+GL_COUNTED(Call, void, glBlendEquation, (GLenum mode), (mode))
+GL_COUNTED(Call, void, glBlendEquationSeparate, (GLenum modeRGB, GLenum modeAlpha), (modeRGB, modeAlpha))
+GL_COUNTED(Call, void, glBlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha))
+GL_COUNTED(Call, void, glBufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), (target, size, data, usage))
+GL_COUNTED(Call, void, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data), (target, offset, size, data))
+GL_COUNTED(Call, GLenum, glCheckFramebufferStatus, (GLenum target), (target))
+GL_COUNTED(Query, GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout))
+GL_COUNTED(Call, void, glClear, (GLbitfield mask), (mask))
+GL_COUNTED(Call, void, glClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha))
+GL_COUNTED(Call, void, glCompileShader, (GLuint shader), (shader))
+GL_COUNTED(Call, GLuint, glCreateProgram, (void), ())
+GL_COUNTED(Call, GLuint, glCreateShader, (GLenum type), (type))
+GL_COUNTED(Call, void, glDeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers))
+GL_COUNTED(Call, void, glDeleteFramebuffers, (GLsizei n, const GLuint *framebuffers), (n, framebuffers))
+GL_COUNTED(Call, void, glDeleteProgram, (GLuint program), (program))
+GL_COUNTED(Call, void, glDeleteRenderbuffers, (GLsizei n, const GLuint *renderbuffers), (n, renderbuffers))
+GL_COUNTED(Call, void, glDeleteShader, (GLuint shader), (shader))
+GL_COUNTED(Call, void, glDeleteSync, (GLsync sync), (sync))
+GL_COUNTED(Call, void, glDeleteTextures, (GLsizei n, const GLuint *textures), (n, textures))
+GL_COUNTED(Call, void, glDeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays))
+GL_COUNTED(Call, void, glDetachShader, (GLuint program, GLuint shader), (program, shader))
+GL_COUNTED(Call, void, glDisable, (GLenum cap), (cap))
+GL_COUNTED(Draw, void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices))
+GL_COUNTED(Call, void, glEnable, (GLenum cap), (cap))
+GL_COUNTED(Call, void, glEnableVertexAttribArray, (GLuint index), (index))
+GL_COUNTED(Call, GLsync, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags))
+GL_COUNTED(Call, void, glFlush, (void), ())
+GL_COUNTED(Call, void, glFramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer))
+GL_COUNTED(Call, void, glGenBuffers, (GLsizei n, GLuint *buffers), (n, buffers))
+GL_COUNTED(Call, void, glGenFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers))
+GL_COUNTED(Call, void, glGenRenderbuffers, (GLsizei n, GLuint *renderbuffers), (n, renderbuffers))
+GL_COUNTED(Call, void, glGenTextures, (GLsizei n, GLuint *textures), (n, textures))
+GL_COUNTED(Call, void, glGenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays))
+GL_COUNTED(Query, GLint, glGetAttribLocation, (GLuint program, const GLchar *name), (program, name))
+GL_COUNTED(Query, GLenum, glGetError, (void), ())
+GL_COUNTED(Query, void, glGetIntegerv, (GLenum pname, GLint *data), (pname, data))
+GL_COUNTED(Query, void, glGetProgramBinary, (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary), (program, bufSize, length, binaryFormat, binary))
+GL_COUNTED(Query, void, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (program, bufSize, length, infoLog))
+GL_COUNTED(Query, void, glGetProgramiv, (GLuint program, GLenum pname, GLint *params), (program, pname, params))
+GL_COUNTED(Query, void, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (shader, bufSize, length, infoLog))
+GL_COUNTED(Query, void, glGetShaderiv, (GLuint shader, GLenum pname, GLint *params), (shader, pname, params))
+GL_COUNTED(Query, const GLubyte *, glGetString, (GLenum name), (name))
+GL_COUNTED(Query, const GLubyte *, glGetStringi, (GLenum name, GLuint index), (name, index))
+GL_COUNTED(Query, GLint, glGetUniformLocation, (GLuint program, const GLchar *name), (program, name))
+GL_COUNTED(Query, GLboolean, glIsEnabled, (GLenum cap), (cap))
+GL_COUNTED(Query, GLboolean, glIsProgram, (GLuint program), (program))
+GL_COUNTED(Call, void, glLinkProgram, (GLuint program), (program))
+GL_COUNTED(Call, void *, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access))
+GL_COUNTED(Call, void, glPixelStorei, (GLenum pname, GLint param), (pname, param))
+GL_COUNTED(Call, void, glProgramBinary, (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length), (program, binaryFormat, binary, length))
+GL_COUNTED(Call, void, glProgramParameteri, (GLuint program, GLenum pname, GLint value), (program, pname, value))
+GL_COUNTED(Call, void, glRenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height))
+GL_COUNTED(Call, void, glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+GL_COUNTED(Call, void, glShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length), (shader, count, string, length))
+GL_COUNTED(Call, void, glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, border, format, type, pixels))
+GL_COUNTED(Call, void, glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param))
+GL_COUNTED(Call, void, glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels))
+GL_COUNTED(Call, GLboolean, glUnmapBuffer, (GLenum target), (target))
+GL_COUNTED(Call, void, glUniform1i, (GLint location, GLint v0), (location, v0))
+GL_COUNTED(Call, void, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value))
+GL_COUNTED(Call, void, glUseProgram, (GLuint program), (program))
+GL_COUNTED(Call, void, glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer))
+GL_COUNTED(Call, void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+
+// Base vertex draws are resolved at runtime; hand out a counting wrapper for them.
+extern "C" __eglMustCastToProperFunctionPointerType eglGetProcAddress(const char *procname)
+{
+    using namespace android::glcounter::detail;
+    static const auto real = reinterpret_cast<__eglMustCastToProperFunctionPointerType (*)(const char *)>(Resolve("eglGetProcAddress"));
+    __eglMustCastToProperFunctionPointerType function = real(procname);
+    if (function && 0 == strncmp(procname, "glDrawElementsBaseVertex", 24))
+    {
+        drawElementsBaseVertex.store(reinterpret_cast<DrawElementsBaseVertexProc>(function), std::memory_order_relaxed);
+        return reinterpret_cast<__eglMustCastToProperFunctionPointerType>(&CountedDrawElementsBaseVertex);
+    }
+    return function;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts the GLES calls of whatever links Host/GlCallCounter.cpp: it defines the GL entry
+// points the renderer uses and forwards them to the driver (dlsym), so the GL cost
+// of a frame can be compared between render paths on a Linux host. Function pointers handed
+// out by eglGetProcAddress are wrapped for glDrawElementsBaseVertex* only. Thread safe.
+
+namespace android::glcounter
+{
+    struct Counters
+    {
+        uint64_t calls = 0;   // every counted entry point, queries included
+        uint64_t queries = 0; // glGet*, glIsEnabled, glIsProgram: round trips to the driver's state
+        uint64_t draws = 0;
+    };
+
+    Counters GetCounters();
+    void ResetCounters();
+
+} // namespace android::glcounter
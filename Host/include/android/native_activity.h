@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for <android/native_activity.h>, only the ANativeActivity layout.
+
+#include <jni.h>
+#include <android/native_window.h>
+
+struct AAssetManager;
+
+typedef struct ANativeActivity
+{
+    struct ANativeActivityCallbacks *callbacks;
+    JavaVM *vm;
+    JNIEnv *env;
+    jobject clazz;
+    const char *internalDataPath;
+    const char *externalDataPath;
+    int32_t sdkVersion;
+    void *instance;
+    AAssetManager *assetManager;
+    const char *obbPath;
+} ANativeActivity;
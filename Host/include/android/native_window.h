@@ -0,0 +1,28 @@
+#pragma once
+
+// Host stand-in for <android/native_window.h>, windows are counted by Host/FakeJni.cpp.
+
+#include <stdint.h>
+
+struct ANativeWindow;
+typedef struct ANativeWindow ANativeWindow;
+
+enum ANativeWindowTransform
+{
+    ANATIVEWINDOW_TRANSFORM_IDENTITY = 0x00,
+    ANATIVEWINDOW_TRANSFORM_MIRROR_HORIZONTAL = 0x01,
+    ANATIVEWINDOW_TRANSFORM_MIRROR_VERTICAL = 0x02,
+    ANATIVEWINDOW_TRANSFORM_ROTATE_90 = 0x04,
+    ANATIVEWINDOW_TRANSFORM_ROTATE_180 = 0x03,
+    ANATIVEWINDOW_TRANSFORM_ROTATE_270 = 0x07,
+};
+
+extern "C"
+{
+    void ANativeWindow_acquire(ANativeWindow *window);
+    void ANativeWindow_release(ANativeWindow *window);
+    int32_t ANativeWindow_getWidth(ANativeWindow *window);
+    int32_t ANativeWindow_getHeight(ANativeWindow *window);
+    int32_t ANativeWindow_setBuffersGeometry(ANativeWindow *window, int32_t width, int32_t height, int32_t format);
+    int32_t ANativeWindow_setBuffersTransform(ANativeWindow *window, int32_t transform);
+}
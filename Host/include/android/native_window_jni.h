@@ -0,0 +1,8 @@
+#pragma once
+
+// Host stand-in for <android/native_window_jni.h>.
+
+#include <jni.h>
+#include <android/native_window.h>
+
+extern "C" ANativeWindow *ANativeWindow_fromSurface(JNIEnv *env, jobject surface);
@@ -0,0 +1,119 @@
+#pragma once
+
+// Host stand-in for <jni.h>: the JNI types plus the JNIEnv/JavaVM members the overlay code
+// calls, implemented by Host/FakeJni.cpp instead of a real VM. Not a complete JNI.
+
+#include <stdarg.h>
+#include <stdint.h>
+
+typedef uint8_t jboolean;
+typedef int8_t jbyte;
+typedef uint16_t jchar;
+typedef int16_t jshort;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef float jfloat;
+typedef double jdouble;
+typedef jint jsize;
+
+class _jobject
+{
+};
+class _jclass : public _jobject
+{
+};
+class _jstring : public _jobject
+{
+};
+class _jthrowable : public _jobject
+{
+};
+
+typedef _jobject *jobject;
+typedef _jclass *jclass;
+typedef _jstring *jstring;
+typedef _jthrowable *jthrowable;
+
+struct _jfieldID;
+typedef struct _jfieldID *jfieldID;
+struct _jmethodID;
+typedef struct _jmethodID *jmethodID;
+
+typedef union jvalue
+{
+    jboolean z;
+    jbyte b;
+    jchar c;
+    jshort s;
+    jint i;
+    jlong j;
+    jfloat f;
+    jdouble d;
+    jobject l;
+} jvalue;
+
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+
+#define JNI_OK (0)
+#define JNI_ERR (-1)
+#define JNI_EDETACHED (-2)
+#define JNI_EVERSION (-3)
+
+#define JNI_VERSION_1_6 0x00010006
+
+struct _JavaVM;
+typedef _JavaVM JavaVM;
+
+struct JavaVMAttachArgs
+{
+    jint version;
+    const char *name;
+    jobject group;
+};
+
+struct _JNIEnv
+{
+    jclass FindClass(const char *name);
+    jmethodID GetMethodID(jclass cls, const char *name, const char *sig);
+    jmethodID GetStaticMethodID(jclass cls, const char *name, const char *sig);
+    jfieldID GetFieldID(jclass cls, const char *name, const char *sig);
+
+    jobject NewObject(jclass cls, jmethodID method, ...);
+    jobject CallObjectMethod(jobject obj, jmethodID method, ...);
+    void CallVoidMethod(jobject obj, jmethodID method, ...);
+    jint CallIntMethod(jobject obj, jmethodID method, ...);
+    jfloat CallFloatMethod(jobject obj, jmethodID method, ...);
+    void CallStaticVoidMethod(jclass cls, jmethodID method, ...);
+    jint GetIntField(jobject obj, jfieldID field);
+    jfloat GetFloatField(jobject obj, jfieldID field);
+
+    jstring NewStringUTF(const char *bytes);
+
+    jobject NewGlobalRef(jobject obj);
+    void DeleteGlobalRef(jobject globalRef);
+    jobject NewLocalRef(jobject ref);
+    void DeleteLocalRef(jobject localRef);
+    jint PushLocalFrame(jint capacity);
+    jobject PopLocalFrame(jobject result);
+
+    jboolean ExceptionCheck();
+    void ExceptionDescribe();
+    void ExceptionClear();
+
+    jint GetJavaVM(JavaVM **vm);
+
+protected:
+    _JNIEnv() = default;
+};
+typedef _JNIEnv JNIEnv;
+
+struct _JavaVM
+{
+    jint AttachCurrentThread(JNIEnv **env, void *args);
+    jint DetachCurrentThread();
+    jint GetEnv(void **env, jint version);
+
+protected:
+    _JavaVM() = default;
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host stand-in for bionic's <sys/system_properties.h>, answered by Host/FakeJni.cpp.
+
+#define PROP_VALUE_MAX 92
+
+extern "C" int __system_property_get(const char *name, char *value);
@@ -1,6 +1,5 @@
 #include <cstdint>
 #include <thread>
-#include <chrono>
 
 #include "../Header/Header.hpp"
 #include "../Header/ANwCreator.hpp"
@@ -11,17 +10,18 @@ static void MyStart()
 {
     std::thread([]
     {
-        while (Data.libUE4 <= 0)
-        {
-            Data.libUE4 = Memory::FindModuleBase("libUE4.so");
-            if (Data.libUE4 > 0) break;
-            sleep(1);
-        }
+        Memory::ModuleData libUE4{};
+        Memory::WaitForModule("libUE4.so", libUE4);
+        Data.libUE4 = libUE4.BaseAddr;
 
         // 参考 android_native_app_glue.h 获取 ANativeActivity
-        android::AImGui imgui({*(ANativeActivity**)(*(uintptr_t*)(Data.libUE4 + 0x16b95990) + sizeof(void*) * 3), true});
+        android::AImGui::Options options;
+        options.activity = *(ANativeActivity**)(*(uintptr_t*)(Data.libUE4 + 0x16b95990) + sizeof(void*) * 3);
+        options.skipScreenshot = true;
+        options.profiler = true;
+        android::AImGui imgui(options);
 
-        bool state = true, showDemoWindow = false, showAnotherWindow = false;
+        bool state = true, showDemoWindow = false, showAnotherWindow = false, showProfiler = false;
         while (state)
         {
             imgui.BeginFrame();
@@ -38,6 +38,7 @@ static void MyStart()
                 ImGui::Text("This is some useful text.");
                 ImGui::Checkbox("Demo Window", &showDemoWindow);
                 ImGui::Checkbox("Another Window", &showAnotherWindow);
+                ImGui::Checkbox("Profiler", &showProfiler);
 
                 ImGui::SliderFloat("float", &f, 0.0f, 1.0f);
 
@@ -50,6 +51,9 @@ static void MyStart()
                 ImGui::End();
             }
 
+            if (showProfiler)
+                imgui.GetProfiler().ShowWindow(&showProfiler);
+
             if (showAnotherWindow)
             {
                 ImGui::Begin("Another Window", &showAnotherWindow);
@@ -60,7 +64,6 @@ static void MyStart()
             }
 
             imgui.EndFrame();
-            std::this_thread::sleep_for(std::chrono::milliseconds(16)); // 60fps
         }
         imgui.Destroy();
 
@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "../Host/GlCallCounter.hpp"
+#include "../Render/AImGui.hpp"
+
+// Renders the demo window offscreen and prints per-phase timings, so the render path
+// can be profiled on a host or CI machine without a device. Throughput and the latency from
+// a finished frame to its swap are printed for serial and render-thread submission alike.
+//
+//   ProjectHeadless [frames] [--render-thread] [--skip-unchanged] [--partial-update] [--idle]
+//                   [--serial-startup] [--program-cache FILE] [--owned-context]
+
+namespace
+{
+    int Usage(const char *argument)
+    {
+        fprintf(stderr, "Unknown argument %s\n"
+                        "usage: ProjectHeadless [frames] [--render-thread] [--skip-unchanged] [--partial-update] [--idle]\n"
+                        "                       [--serial-startup] [--program-cache FILE] [--owned-context]\n",
+                argument);
+        return 2;
+    }
+
+    // Runs frames back to back instead of pacing them to a display.
+    class UnpacedClock : public android::SteadyFrameClock
+    {
+    public:
+        void SleepUntil(int64_t) override {}
+    };
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 600;
+
+    android::AImGui::Options options;
+    options.headless = true;
+    options.width = 1920;
+    options.height = 1080;
+    options.profiler = true;
+    options.profileGpu = true;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--render-thread"))
+            options.renderThread = true;
+        else if (0 == strcmp(argv[i], "--skip-unchanged"))
+            options.skipUnchangedFrames = true;
+        else if (0 == strcmp(argv[i], "--partial-update"))
+            options.partialUpdate = true;
+        else if (0 == strcmp(argv[i], "--idle"))
+            options.idleFrameRate = 10.0f;
+        else if (0 == strcmp(argv[i], "--serial-startup"))
+            options.parallelStartup = false;
+        else if (0 == strcmp(argv[i], "--program-cache") && i + 1 < argc)
+            options.programCachePath = argv[++i];
+        else if (0 == strcmp(argv[i], "--owned-context"))
+            options.ownedContext = true;
+        else
+        {
+            // Anything else has to be the frame count, a typo must not run zero frames.
+            char *end = nullptr;
+            long count = strtol(argv[i], &end, 10);
+            if (end == argv[i] || *end || count <= 0 || count > INT32_MAX)
+                return Usage(argv[i]);
+            frames = static_cast<int>(count);
+        }
+    }
+
+    UnpacedClock clock;
+    options.frameClock = &clock;
+
+    android::AImGui imgui(options);
+    if (!imgui.IsValid())
+    {
+        fprintf(stderr, "Headless init failed\n");
+        return 1;
+    }
+
+    // Unpaced, the UI thread would outrun the GL thread and replace nearly every frame before
+    // it got drawn. The next frame is still built while the last one draws, but only handed
+    // over once the GL thread is free to take it.
+    const auto &frameStats = imgui.GetFrameStats();
+    const auto &renderStats = imgui.GetRenderThreadStats();
+    auto framesInFlight = [&]
+    {
+        return frameStats.framesSubmitted - frameStats.framesDropped - renderStats.framesRendered.load(std::memory_order_relaxed);
+    };
+
+    android::glcounter::ResetCounters();
+    const int64_t start = clock.Now();
+    for (int i = 0; i < frames; ++i)
+    {
+        imgui.BeginFrame();
+        ImGui::ShowDemoWindow();
+        while (options.renderThread && framesInFlight() > 0)
+            std::this_thread::yield();
+        imgui.EndFrame();
+    }
+    while (options.renderThread && framesInFlight() > 0)
+        std::this_thread::yield();
+    const int64_t elapsed = clock.Now() - start;
+
+    const auto &startup = imgui.GetStartupStats();
+    printf("startup %.2f ms (stages %.2f ms, %s), first frame after %.2f ms\n", startup.initTime * 1e-6,
+           startup.stagesTime * 1e-6, startup.parallel ? "parallel" : "serial", startup.firstFrameTime * 1e-6);
+    if (options.programCachePath)
+        printf("program cache %s: load %.3f ms, build %.3f ms, saved %.3f ms\n",
+               startup.programCache.loaded ? "hit" : startup.programCache.saved ? "miss, written" : "miss",
+               startup.programCache.loadTime * 1e-6, startup.programCache.buildTime * 1e-6, startup.programCache.GetTimeSaved() * 1e-6);
+
+    const auto &profiler = imgui.GetProfiler();
+    for (int32_t i = 0; i < android::FrameProfiler::PhaseCount; ++i)
+    {
+        auto phase = static_cast<android::FrameProfiler::Phase>(i);
+        auto wall = profiler.GetPercentiles(phase);
+        auto cpu = profiler.GetPercentiles(phase, true);
+        printf("%-8s wall p50 %7.3f p95 %7.3f p99 %7.3f | cpu p50 %7.3f p95 %7.3f p99 %7.3f ms\n",
+               android::FrameProfiler::GetPhaseName(phase), wall.p50, wall.p95, wall.p99, cpu.p50, cpu.p95, cpu.p99);
+    }
+
+    const auto &stats = imgui.GetFrameStats();
+    printf("frames %d submitted %llu skipped %llu dropped %llu\n", frames,
+           static_cast<unsigned long long>(stats.framesSubmitted),
+           static_cast<unsigned long long>(stats.framesSkipped),
+           static_cast<unsigned long long>(stats.framesDropped));
+    printf("%s: %.1f frames/s, latency last %.3f max %.3f ms over %llu frames\n",
+           options.renderThread ? "render thread" : "serial", frames / (elapsed * 1e-9),
+           renderStats.lastLatency.load() * 1e-6, renderStats.maxLatency.load() * 1e-6,
+           static_cast<unsigned long long>(renderStats.framesRendered.load()));
+    if (options.idleFrameRate > 0.0f)
+        printf("idle frames %llu\n", static_cast<unsigned long long>(imgui.GetFrameScheduler().GetStats().idleFrames));
+
+    const android::glcounter::Counters gl = android::glcounter::GetCounters();
+    const double submitted = stats.framesSubmitted ? static_cast<double>(stats.framesSubmitted) : 1.0;
+    printf("gl calls per frame %.1f (queries %.1f, draws %.1f)%s\n", gl.calls / submitted, gl.queries / submitted,
+           gl.draws / submitted, options.ownedContext ? ", owned context" : "");
+
+    imgui.Destroy();
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../Header/ANwCreator.hpp"
+#include "../Host/FakeJni.hpp"
+
+// Runs ANwCreator against the fake JavaVM in Host/ and prints, per operation, the time and
+// the JNI calls and references it costs. Local or global refs, objects or windows left
+// behind after an operation are reported as leaks and make the exit code non-zero.
+//
+//   ProjectJniBench [iterations] [--api N] [--verbose] [--log]
+
+namespace
+{
+    using android::fakejni::Counters;
+    using android::fakejni::Function;
+    using android::fakejni::VirtualMachine;
+
+    struct Options
+    {
+        int iterations = 10000;
+        bool verbose = false;
+    };
+
+    // Runs `operation` the given number of times and prints what one run costs. With
+    // `retains`, whatever the operation keeps for later is not reported as a leak.
+    template <typename operation_t>
+    bool Measure(VirtualMachine &vm, const Options &options, const char *name, int iterations, bool retains, operation_t &&operation)
+    {
+        vm.ResetCounters();
+        const Counters before = vm.GetCounters();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            operation();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        const Counters &after = vm.GetCounters();
+        const double runs = static_cast<double>(iterations);
+        printf("%-16s %9.0f ns | jni %6.1f | local %5.1f | global %4.1f | objects %4.1f | transactions %4.2f (%4.1f ops)\n",
+               name, elapsed / runs, after.GetTotalCalls() / runs,
+               after.localRefsCreated / runs, after.globalRefsCreated / runs, after.objectsAllocated / runs,
+               after.transactionsApplied / runs, after.transactionOperations / runs);
+
+        if (options.verbose)
+        {
+            for (int32_t i = 0; i < android::fakejni::FunctionCount; ++i)
+                if (after.calls[i])
+                    printf("    %-22s %8.2f\n", VirtualMachine::GetFunctionName(static_cast<Function>(i)), after.calls[i] / runs);
+        }
+
+        bool leaked = false;
+        auto check = [&](const char *what, int64_t from, int64_t to)
+        {
+            if (from == to || retains)
+                return;
+            printf("    LEAK: %lld %s left after %d runs\n", static_cast<long long>(to - from), what, iterations);
+            leaked = true;
+        };
+        check("local refs", before.localRefs, after.localRefs);
+        check("global refs", before.globalRefs, after.globalRefs);
+        check("objects", before.objects, after.objects);
+        check("windows", before.windows, after.windows);
+        return !leaked;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    android::fakejni::Config config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--api") && i + 1 < argc)
+            config.apiLevel = atoi(argv[++i]);
+        else if (0 == strcmp(argv[i], "--verbose"))
+            options.verbose = true;
+        else if (0 == strcmp(argv[i], "--log"))
+            config.log = true;
+        else
+            options.iterations = atoi(argv[i]);
+    }
+
+    VirtualMachine vm(config);
+    ANativeActivity *activity = vm.GetActivity();
+    printf("API %d, %d iterations\n", config.apiLevel, options.iterations);
+
+    bool clean = true;
+
+    // The first calls resolve the class cache and the display, both kept for the process lifetime.
+    clean &= Measure(vm, options, "ClassCache", 1, true, [&]
+                     { android::anwcreator::detail::jni::ClassCache::Get(activity->env); });
+    clean &= Measure(vm, options, "DisplayRefresh", 1, true, [&]
+                     { android::ANwCreator::GetDisplayInfo(activity); });
+    const int64_t cacheGlobals = vm.GetCounters().globalRefs;
+
+    clean &= Measure(vm, options, "GetDisplayInfo", options.iterations, false, [&]
+                     { android::ANwCreator::GetDisplayInfo(activity); });
+
+    clean &= Measure(vm, options, "PollDisplay", options.iterations, false, [&]
+                     { android::ANwCreator::PollDisplay(activity, 0); });
+
+    // A rotation must show up on the next poll, with the metrics re-read.
+    const android::ANwCreator::DisplayInfo portrait = android::ANwCreator::GetDisplayInfo(activity);
+    vm.SetRotation(portrait.theta / 90 + 1);
+    const bool rotated = android::ANwCreator::PollDisplay(activity, 0);
+    const android::ANwCreator::DisplayInfo landscape = android::ANwCreator::GetDisplayInfo(activity);
+    if (!rotated || landscape.width != portrait.height || landscape.height != portrait.width ||
+        landscape.generation == portrait.generation)
+    {
+        printf("PollDisplay missed a rotation: %dx%d -> %dx%d\n", portrait.width, portrait.height, landscape.width, landscape.height);
+        clean = false;
+    }
+    vm.SetRotation(portrait.theta / 90);
+    android::ANwCreator::PollDisplay(activity, 0);
+
+    clean &= Measure(vm, options, "Create+Destroy", options.iterations, false, [&]
+                     {
+                         ANativeWindow *window = android::ANwCreator::Create(activity);
+                         if (!window)
+                         {
+                             fprintf(stderr, "Create failed\n");
+                             exit(1);
+                         }
+                         android::ANwCreator::Destroy(activity, window);
+                     });
+
+    ANativeWindow *window = android::ANwCreator::Create(activity);
+    if (!window)
+    {
+        fprintf(stderr, "Create failed\n");
+        return 1;
+    }
+
+    // The first Apply() creates the transaction the window keeps.
+    android::ANwCreator::SetAlpha(window, 0.9f);
+    android::ANwCreator::Apply(activity, window);
+
+    int frame = 0;
+    clean &= Measure(vm, options, "Geometry+Apply", options.iterations, false, [&]
+                     {
+                         int32_t x = 64 * (++frame % 8);
+                         android::ANwCreator::SetGeometry(window, x, 0, 1024, 512, 512, 256);
+                         android::ANwCreator::SetAlpha(window, 0.5f + 0.1f * (frame % 4));
+                         android::ANwCreator::Apply(activity, window);
+                     });
+
+    clean &= Measure(vm, options, "Apply unchanged", options.iterations, false, [&]
+                     { android::ANwCreator::Apply(activity, window); });
+
+    // Idle/active switches of the frame rate vote, one setter each. Before API 30 SetFrameRate
+    // fails and nothing is applied.
+    clean &= Measure(vm, options, "FrameRate+Apply", options.iterations, false, [&]
+                     {
+                         android::ANwCreator::SetFrameRate(window, ++frame % 2 ? 10.0f : 120.0f);
+                         android::ANwCreator::Apply(activity, window);
+                     });
+
+    clean &= Measure(vm, options, "Opaque+Apply", options.iterations, false, [&]
+                     {
+                         android::ANwCreator::SetOpaque(window, ++frame % 2);
+                         android::ANwCreator::Apply(activity, window);
+                     });
+
+    android::ANwCreator::TransactionStats stats;
+    if (android::ANwCreator::GetTransactionStats(window, &stats))
+        printf("window transactions %llu, properties applied %llu, coalesced %llu\n",
+               static_cast<unsigned long long>(stats.transactionsApplied),
+               static_cast<unsigned long long>(stats.propertiesApplied),
+               static_cast<unsigned long long>(stats.propertiesCoalesced));
+
+    // Lookups stay lock-free while another thread keeps resizing the overlay.
+    android::ANwCreator::SetGeometry(window, 0, 0, 512, 256);
+    std::atomic<bool> resizing{true};
+    std::thread resizer([&]
+                        {
+                            for (int32_t i = 0; resizing.load(std::memory_order_relaxed); ++i)
+                                android::ANwCreator::SetGeometry(window, 0, 0, 512 + i % 512, 256);
+                        });
+    int32_t sizeErrors = 0;
+    clean &= Measure(vm, options, "IsValid+Size", options.iterations, false, [&]
+                     {
+                         int32_t width = 0, height = 0;
+                         if (!android::ANwCreator::IsValid(window) ||
+                             !android::ANwCreator::GetWindowSize(window, &width, &height) || width < 512 || height != 256)
+                             ++sizeErrors;
+                     });
+    resizing = false;
+    resizer.join();
+    if (sizeErrors)
+    {
+        printf("GetWindowSize returned %d torn or missing sizes\n", sizeErrors);
+        clean = false;
+    }
+
+    // Independent overlays until the registry is full, each with its own layer and buffer size.
+    std::vector<ANativeWindow *> overlays;
+    clean &= Measure(vm, options, "Fill overlays", 1, true, [&]
+                     {
+                         for (size_t i = android::ANwCreator::GetWindowCount(); i < android::ANwCreator::kMaxWindows; ++i)
+                         {
+                             android::ANwCreator::CreateOptions overlayOptions;
+                             overlayOptions.name = "overlay";
+                             overlayOptions.width = 256;
+                             overlayOptions.height = 128;
+                             overlayOptions.bufferWidth = 128;
+                             overlayOptions.bufferHeight = 64;
+                             overlayOptions.layer = android::ANwCreator::kDefaultLayer - static_cast<int32_t>(i);
+                             overlayOptions.flags = android::ANwCreator::SurfaceControlFlags::eHidden;
+                             overlays.push_back(android::ANwCreator::Create(activity, overlayOptions));
+                         }
+                     });
+    if (android::ANwCreator::Create(activity) || android::ANwCreator::GetWindowCount() != android::ANwCreator::kMaxWindows)
+    {
+        printf("Create succeeded past %zu overlays\n", android::ANwCreator::kMaxWindows);
+        clean = false;
+    }
+    for (ANativeWindow *overlay : overlays)
+        android::ANwCreator::Destroy(activity, overlay);
+
+    android::ANwCreator::Destroy(activity, window);
+
+    // Only the class cache and the activity may hold global refs at the end.
+    const Counters &counters = vm.GetCounters();
+    if (counters.globalRefs != cacheGlobals || counters.windows != 0)
+    {
+        printf("LEAK: %lld global refs, %lld windows left at exit\n",
+               static_cast<long long>(counters.globalRefs - cacheGlobals), static_cast<long long>(counters.windows));
+        clean = false;
+    }
+
+    return clean ? 0 : 1;
+}
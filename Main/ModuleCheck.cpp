@@ -0,0 +1,77 @@
+#include <dlfcn.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "../Header/Memory.hpp"
+
+// Loads and unloads a module (Host/EmptyModule.cpp) and checks that Memory::ModuleRegistry
+// picks both up, walking only the tail for the load and rebuilding for the unload, while
+// repeated queries of an unchanged list rebuild nothing. Runs once with the loader's
+// dlpi_adds/dlpi_subs counters and once the way a loader without them is handled. Any
+// failed check makes the exit code non-zero.
+//
+//   ProjectModuleCheck MODULE_PATH
+
+namespace
+{
+    int g_failures = 0;
+
+    void Expect(bool ok, const char *mode, const char *what)
+    {
+        printf("%s %-11s %s\n", ok ? "ok  " : "FAIL", mode, what);
+        if (!ok)
+            ++g_failures;
+    }
+
+    void Check(const char *path, bool useCounters)
+    {
+        const char *mode = useCounters ? "counters" : "no counters";
+        const char *slash = strrchr(path, '/');
+        const std::string name = slash ? slash + 1 : path;
+
+        Memory::ModuleRegistry registry(useCounters);
+        Memory::ModuleData data{};
+
+        Expect(!registry.Find(name, &data), mode, "module not found before it is loaded");
+        Expect(useCounters == registry.HasLoadCounters(), mode, "load counters used as asked");
+        for (int i = 0; i < 100; ++i)
+            registry.Find(name, &data);
+        Expect(1 == registry.GetRebuildCount() && 0 == registry.GetUpdateCount(), mode, "unchanged list, nothing walked again");
+
+        void *module = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        if (!module)
+        {
+            Expect(false, mode, dlerror());
+            return;
+        }
+
+        void *marker = dlsym(module, "EmptyModuleMarker");
+        bool found = registry.Find(name, &data);
+        Expect(found, mode, "module found after dlopen");
+        Expect(found && reinterpret_cast<uintptr_t>(marker) >= data.BaseAddr && reinterpret_cast<uintptr_t>(marker) < data.EndAddr,
+               mode, "module bounds cover its code");
+        Expect(1 == registry.GetRebuildCount() && 1 == registry.GetUpdateCount(), mode, "a load only walks the tail");
+
+        dlclose(module);
+        Expect(!registry.Find(name, &data), mode, "module gone after dlclose");
+        Expect(2 == registry.GetRebuildCount() && 1 == registry.GetUpdateCount(), mode, "an unload rebuilds");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: ProjectModuleCheck MODULE_PATH\n");
+        return 2;
+    }
+
+    Check(argv[1], true);
+    Check(argv[1], false);
+
+    if (g_failures)
+        printf("%d checks failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
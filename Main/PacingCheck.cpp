@@ -0,0 +1,267 @@
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "../Render/FrameScheduler.hpp"
+
+// Drives FrameScheduler from a fake clock and checks the pacing it produces: frames on the
+// grid, overruns re-phased without catch-up bursts, idle switches, and swap-paced frames
+// against a simulated display whose real refresh rate differs from the reported one. Any
+// failed check makes the exit code non-zero.
+//
+//   ProjectPacingCheck
+
+namespace
+{
+    using android::FrameClock;
+    using android::FrameScheduler;
+
+    constexpr int64_t kMillisecond = 1000000;
+
+    // Time only moves when the test or a sleep moves it. Every sleep deadline is recorded.
+    class FakeClock : public FrameClock
+    {
+    public:
+        int64_t Now() override { return m_now; }
+
+        void SleepUntil(int64_t deadline) override
+        {
+            m_sleeps.push_back(deadline);
+            if (deadline > m_now)
+                m_now = deadline;
+        }
+
+        void Advance(int64_t time) { m_now += time; }
+        void Set(int64_t time) { m_now = time; }
+        const std::vector<int64_t> &GetSleeps() const { return m_sleeps; }
+
+    private:
+        int64_t m_now = 1000 * kMillisecond;
+        std::vector<int64_t> m_sleeps;
+    };
+
+    // A BufferQueue in front of a display: each latched buffer stays up for at least
+    // `interval` vsyncs, two buffers may be queued, and a swap blocks until one of them is
+    // latched. A vsync that finds nothing queued after the interval repeats the old frame.
+    class FakeDisplay
+    {
+    public:
+        FakeDisplay(double refreshRate, int32_t interval)
+            : m_period(static_cast<int64_t>(1e9 / refreshRate)), m_interval(interval)
+        {
+        }
+
+        // Returns when the swap at `now` comes back.
+        int64_t Swap(int64_t now)
+        {
+            while (m_nextVsync <= now)
+                Vsync();
+
+            ++m_queued;
+            while (m_queued >= 2)
+            {
+                now = m_nextVsync;
+                Vsync();
+            }
+            return now;
+        }
+
+        void ResetStats()
+        {
+            m_latches = 0;
+            m_repeats = 0;
+        }
+
+        uint64_t GetLatches() const { return m_latches; }
+        uint64_t GetRepeats() const { return m_repeats; }
+
+    private:
+        void Vsync()
+        {
+            if (++m_shown >= m_interval)
+            {
+                if (m_queued > 0)
+                {
+                    --m_queued;
+                    ++m_latches;
+                    m_shown = 0;
+                }
+                else if (m_started)
+                {
+                    ++m_repeats;
+                }
+                m_started = m_started || m_latches > 0;
+            }
+            m_nextVsync += m_period;
+        }
+
+        int64_t m_period;
+        int32_t m_interval;
+        int64_t m_nextVsync = 1000 * kMillisecond + 3 * kMillisecond; // any phase against the clock
+        int32_t m_queued = 0;
+        int32_t m_shown = 0;
+        bool m_started = false;
+        uint64_t m_latches = 0;
+        uint64_t m_repeats = 0;
+    };
+
+    int g_failures = 0;
+
+    void Expect(bool ok, const char *what)
+    {
+        printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+        if (!ok)
+            ++g_failures;
+    }
+
+    void CheckGrid()
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        scheduler.SetDisplayRefreshRate(120.0f);
+        scheduler.SetTargetFrameRate(30.0f);
+        Expect(4 == scheduler.GetSwapInterval(), "30 fps on 120 Hz is every 4th vsync");
+
+        scheduler.SetDisplayRefreshRate(60.0f);
+        scheduler.SetTargetFrameRate(45.0f);
+        Expect(1 == scheduler.GetSwapInterval(), "45 fps on 60 Hz snaps to every vsync");
+
+        scheduler.SetTargetFrameRate(30.0f);
+        const int64_t period = scheduler.GetFramePeriod();
+        for (int i = 0; i < 100; ++i)
+        {
+            clock.Advance(5 * kMillisecond);
+            scheduler.WaitForNextFrame();
+        }
+
+        const std::vector<int64_t> &sleeps = clock.GetSleeps();
+        bool onGrid = true;
+        for (size_t i = 1; i < sleeps.size(); ++i)
+            onGrid = onGrid && period == sleeps[i] - sleeps[i - 1];
+        Expect(onGrid, "frames start one period apart");
+        Expect(0 == scheduler.GetStats().missedDeadlines, "no missed deadlines under budget");
+    }
+
+    void CheckOverrun()
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        scheduler.SetDisplayRefreshRate(60.0f);
+        const int64_t period = scheduler.GetFramePeriod();
+
+        scheduler.WaitForNextFrame();
+        const int64_t origin = clock.Now();
+
+        clock.Advance(period * 5 / 2);
+        scheduler.WaitForNextFrame();
+        const int64_t resumed = clock.Now();
+
+        clock.Advance(kMillisecond);
+        scheduler.WaitForNextFrame();
+
+        const FrameScheduler::Stats &stats = scheduler.GetStats();
+        Expect(1 == stats.missedDeadlines, "an overrun counts one missed deadline");
+        Expect(2 == stats.droppedIntervals, "2.5 periods of work drop two slots");
+        Expect(0 == (resumed - origin) % period, "the grid keeps its phase after an overrun");
+        Expect(period == clock.Now() - resumed, "no catch-up frame after an overrun");
+    }
+
+    void CheckIdle()
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        scheduler.SetDisplayRefreshRate(60.0f);
+        scheduler.SetIdleFrameRate(10.0f, 1000 * kMillisecond);
+        const int64_t activePeriod = scheduler.GetFramePeriod();
+
+        for (int i = 0; i < 70; ++i)
+            scheduler.WaitForNextFrame();
+        Expect(scheduler.IsIdle(), "idle after the timeout");
+        Expect(6 == scheduler.GetSwapInterval(), "10 fps idle is every 6th vsync");
+
+        const int64_t idleStart = clock.Now();
+        scheduler.WaitForNextFrame();
+        Expect(scheduler.GetFramePeriod() == clock.Now() - idleStart, "idle frames use the idle period");
+
+        clock.Advance(2 * kMillisecond);
+        const int64_t frameStart = clock.GetSleeps().back();
+        scheduler.NotifyActivity();
+        Expect(!scheduler.IsIdle(), "activity leaves idle");
+        scheduler.WaitForNextFrame();
+        Expect(activePeriod == clock.Now() - frameStart, "the next slot follows the active period");
+    }
+
+    // Returns the repeated frames seen after a warm-up, with the display running at
+    // `realRefreshRate` while the scheduler was told 60 Hz.
+    uint64_t RunAgainstDisplay(double realRefreshRate, bool swapPaced, FrameScheduler::Stats *outStats)
+    {
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        scheduler.SetDisplayRefreshRate(60.0f);
+        scheduler.SetTargetFrameRate(30.0f);
+        scheduler.SetSwapPaced(swapPaced);
+
+        FakeDisplay display(realRefreshRate, scheduler.GetSwapInterval());
+        for (int i = 0; i < 2000; ++i)
+        {
+            if (200 == i)
+            {
+                display.ResetStats();
+                scheduler.Reset();
+                scheduler.SetSwapPaced(swapPaced);
+            }
+
+            clock.Advance(4 * kMillisecond);
+            clock.Set(display.Swap(clock.Now()));
+            scheduler.WaitForNextFrame();
+        }
+
+        if (outStats)
+            *outStats = scheduler.GetStats();
+        return display.GetRepeats();
+    }
+
+    void CheckSwapPaced()
+    {
+        FrameScheduler::Stats stats;
+        uint64_t fastTimer = RunAgainstDisplay(60.0, false, nullptr);
+        uint64_t slowTimer = RunAgainstDisplay(60.5, false, nullptr);
+        printf("     timer only: %" PRIu64 " repeated frames at 60 Hz, %" PRIu64 " at 60.5 Hz\n", fastTimer, slowTimer);
+
+        Expect(0 == RunAgainstDisplay(60.0, true, &stats), "swap paced, no repeated frames at 60 Hz");
+        Expect(0 == stats.missedDeadlines, "swap paced, no missed deadlines at 60 Hz");
+        Expect(0 == RunAgainstDisplay(60.5, true, &stats), "swap paced, no repeated frames on a faster display");
+        Expect(0 == stats.missedDeadlines, "swap paced, no missed deadlines on a faster display");
+        Expect(stats.swapWaits > 0, "swap paced, the grid follows the swap");
+        Expect(0 == RunAgainstDisplay(59.5, true, &stats), "swap paced, no repeated frames on a slower display");
+        Expect(0 == stats.missedDeadlines, "swap paced, no missed deadlines on a slower display");
+
+        FakeClock clock;
+        FrameScheduler scheduler(&clock);
+        scheduler.SetDisplayRefreshRate(60.0f);
+        scheduler.SetSwapPaced(true);
+        const int64_t period = scheduler.GetFramePeriod();
+        scheduler.WaitForNextFrame();
+        clock.Advance(period + 3 * kMillisecond);
+        const int64_t held = clock.Now();
+        scheduler.WaitForNextFrame();
+        Expect(held == clock.GetSleeps().back(), "a frame held by the swap re-phases the grid to it");
+        Expect(1 == scheduler.GetStats().swapWaits && 0 == scheduler.GetStats().missedDeadlines, "a held frame is not a missed deadline");
+
+        clock.Advance(3 * period);
+        scheduler.WaitForNextFrame();
+        Expect(1 == scheduler.GetStats().missedDeadlines, "swap paced, a real overrun still counts");
+    }
+}
+
+int main()
+{
+    CheckGrid();
+    CheckOverrun();
+    CheckIdle();
+    CheckSwapPaced();
+
+    if (g_failures)
+        printf("%d checks failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+#include <cstdio>
+
+#include "../Header/ANwCreator.hpp"
+#include "../Host/FakeJni.hpp"
+#include "../Host/FakeSurfaceControl.hpp"
+
+// Runs ANwCreator's NDK path (ASurfaceControl/ASurfaceTransaction) against the fake table in
+// Host/: the layer is taken over from Java on creation, only the properties changed since
+// the last Apply() reach the transaction, nothing goes through JNI on the way, and
+// destroying the overlay reparents the layer to null and releases everything it held. Any
+// failed check makes the exit code non-zero.
+//
+//   ProjectSurfaceControlCheck
+
+namespace
+{
+    using android::ANwCreator;
+    namespace fake = android::fakesurfacecontrol;
+
+    int g_failures = 0;
+
+    void Expect(bool ok, const char *what)
+    {
+        printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+        if (!ok)
+            ++g_failures;
+    }
+
+    uint64_t Calls(fake::Function function)
+    {
+        return fake::GetCounters().calls[function];
+    }
+
+    // Only `function` (besides creating and applying the transaction) was called, once.
+    bool OnlySetter(fake::Function function)
+    {
+        return 1 == Calls(function) && 1 == fake::GetCounters().GetSetterCalls();
+    }
+
+    void CheckNativePath(android::fakejni::VirtualMachine &vm)
+    {
+        ANativeActivity *activity = vm.GetActivity();
+
+        fake::ResetCounters();
+        ANativeWindow *window = ANwCreator::Create(activity);
+        Expect(window, "Create succeeds");
+        if (!window)
+            return;
+
+        Expect(ANwCreator::IsNative(window), "the window is driven through ASurfaceTransaction");
+        Expect(1 == Calls(fake::FromJava) && 1 == fake::GetCounters().surfaceControls, "the Java layer is taken over once");
+        Expect(1 == Calls(fake::TransactionApply) && 0 == fake::GetCounters().transactions, "creation applies one transaction and frees it");
+        Expect(1 == Calls(fake::SetZOrder) && 1 == Calls(fake::SetBufferAlpha), "creation sets the layer and alpha natively");
+
+        fake::ResetCounters();
+        vm.ResetCounters();
+        ANwCreator::SetGeometry(window, 10, 20, 1024, 512, 512, 256);
+        Expect(ANwCreator::Apply(activity, window), "Apply succeeds");
+
+        const fake::Staged &staged = fake::GetStaged();
+        Expect(1 == Calls(fake::TransactionApply), "a geometry change applies one transaction");
+        Expect(2 == fake::GetCounters().GetSetterCalls(), "a geometry change emits two setters");
+        Expect(1 == Calls(fake::SetPosition) && 10 == staged.x && 20 == staged.y, "the position is staged");
+        Expect(1 == Calls(fake::SetScale) && 2.0f == staged.scaleX && 2.0f == staged.scaleY, "the scale is staged");
+        Expect(0 == vm.GetCounters().GetTotalCalls(), "staging and applying make no JNI call");
+
+        fake::ResetCounters();
+        ANwCreator::SetGeometry(window, 10, 20, 1024, 512, 512, 256);
+        Expect(ANwCreator::Apply(activity, window), "Apply with nothing changed succeeds");
+        Expect(0 == Calls(fake::TransactionApply), "an unchanged geometry applies nothing");
+
+        fake::ResetCounters();
+        ANwCreator::SetAlpha(window, 0.5f);
+        ANwCreator::SetAlpha(window, 0.75f);
+        ANwCreator::Apply(activity, window);
+        Expect(OnlySetter(fake::SetBufferAlpha) && 0.75f == staged.alpha, "a changed alpha emits one setter with the last value");
+
+        fake::ResetCounters();
+        ANwCreator::SetCrop(window, 0, 0, 256, 128);
+        ANwCreator::Apply(activity, window);
+        Expect(OnlySetter(fake::SetCrop) && 256 == staged.crop.right && 128 == staged.crop.bottom, "a crop emits one setter");
+
+        fake::ResetCounters();
+        ANwCreator::SetFrameRate(window, 30.0f);
+        ANwCreator::Apply(activity, window);
+        Expect(OnlySetter(fake::SetFrameRate) && 30.0f == staged.frameRate, "a frame rate vote emits one setter");
+        Expect(0 == fake::GetCounters().emptyApplies, "no empty transaction was applied");
+
+        fake::ResetCounters();
+        ANwCreator::Destroy(activity, window);
+        Expect(1 == Calls(fake::Reparent) && nullptr == staged.parent, "Destroy reparents the layer to null");
+        Expect(1 == Calls(fake::TransactionApply), "the removal is applied");
+        Expect(0 == fake::GetCounters().surfaceControls, "the native layer is released");
+        Expect(0 == fake::GetCounters().transactions, "the window's transaction is freed");
+        Expect(0 == vm.GetCounters().windows, "the window is released");
+    }
+
+    // Before API 30 there is no setFrameRate, a vote must not leave an empty transaction.
+    void CheckWithoutFrameRate(android::fakejni::VirtualMachine &vm)
+    {
+        ANativeActivity *activity = vm.GetActivity();
+        ANativeWindow *window = ANwCreator::Create(activity);
+        Expect(window && ANwCreator::IsNative(window), "Create succeeds without setFrameRate");
+        if (!window)
+            return;
+
+        fake::ResetCounters();
+        Expect(!ANwCreator::SetFrameRate(window, 30.0f), "SetFrameRate fails without setFrameRate");
+        ANwCreator::Apply(activity, window);
+        Expect(0 == Calls(fake::TransactionApply), "a vote that cannot be sent applies nothing");
+
+        ANwCreator::Destroy(activity, window);
+        Expect(0 == fake::GetCounters().surfaceControls && 0 == fake::GetCounters().transactions, "nothing is left behind");
+    }
+}
+
+int main()
+{
+    android::fakejni::VirtualMachine vm;
+
+    // The table is looked up on creation and with every transaction, it stays installed
+    // until the last window is gone.
+    android::anwcreator::native::SurfaceControlApi::Override(&fake::GetApi());
+    CheckNativePath(vm);
+
+    android::anwcreator::native::SurfaceControlApi withoutFrameRate = fake::GetApi();
+    withoutFrameRate.setFrameRate = nullptr;
+    android::anwcreator::native::SurfaceControlApi::Override(&withoutFrameRate);
+    CheckWithoutFrameRate(vm);
+    android::anwcreator::native::SurfaceControlApi::Override(nullptr);
+
+    if (g_failures)
+        printf("%d checks failed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
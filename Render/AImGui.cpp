@@ -1,11 +1,71 @@
 #include "AImGui.hpp"
+
+#include <imgui_internal.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#ifdef __ANDROID__
 #include "../Header/ANwCreator.hpp"
+#else
+#include <cstdio>
+#define LogInfo(formatter, ...) fprintf(stdout, "[AImGui] " formatter "\n" __VA_OPT__(, ) __VA_ARGS__)
+#define LogError(formatter, ...) fprintf(stderr, "[AImGui] " formatter "\n" __VA_OPT__(, ) __VA_ARGS__)
+#endif
+
+// ImGui's current context, per thread (see imconfig.h).
+thread_local ImGuiContext *AImGuiCurrentContext = nullptr;
 
 namespace android
 {
+    namespace
+    {
+        // Display rect to {x, y, width, height} in framebuffer pixels, bottom-left origin as
+        // glScissor and eglSwapBuffersWithDamageKHR expect. Rounded outwards.
+        void ToFramebufferRect(const ImDrawData *drawData, const ImVec4 &rect, EGLint outBox[4])
+        {
+            const ImVec2 &pos = drawData->DisplayPos;
+            const ImVec2 &scale = drawData->FramebufferScale;
+            const float fbWidth = drawData->DisplaySize.x * scale.x;
+            const float fbHeight = drawData->DisplaySize.y * scale.y;
+
+            float x1 = fmaxf(floorf((rect.x - pos.x) * scale.x), 0.0f);
+            float y1 = fmaxf(floorf((rect.y - pos.y) * scale.y), 0.0f);
+            float x2 = fminf(ceilf((rect.z - pos.x) * scale.x), fbWidth);
+            float y2 = fminf(ceilf((rect.w - pos.y) * scale.y), fbHeight);
+
+            outBox[0] = static_cast<EGLint>(x1);
+            outBox[1] = static_cast<EGLint>(fbHeight - y2);
+            outBox[2] = static_cast<EGLint>(fmaxf(x2 - x1, 0.0f));
+            outBox[3] = static_cast<EGLint>(fmaxf(y2 - y1, 0.0f));
+        }
+
+        // Union of what the draw lists cover, (x1, y1, x2, y2) in display space.
+        ImVec4 ComputeContentBounds(const ImDrawData *drawData)
+        {
+            ImVec4 display(drawData->DisplayPos.x, drawData->DisplayPos.y,
+                           drawData->DisplayPos.x + drawData->DisplaySize.x, drawData->DisplayPos.y + drawData->DisplaySize.y);
+
+            ImVec4 content(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const ImDrawList *drawList : drawData->CmdLists)
+                content = DamageTracker::Union(content, DamageTracker::ComputeBounds(drawList, display));
+            return content;
+        }
+
+        // The user is touching, dragging or typing.
+        bool HasInput(const ImGuiIO &io)
+        {
+            return io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f || io.MouseWheel != 0.0f ||
+                   ImGui::IsAnyMouseDown() || ImGui::IsAnyItemActive() || io.InputQueueCharacters.Size > 0;
+        }
+    } // namespace
+
     AImGui::AImGui(const Options &options)
-        : m_options(options)
+        : m_options(options), m_frameScheduler(options.frameClock)
     {
+        m_frameScheduler.SetIdleFrameRate(options.idleFrameRate, options.idleTimeout);
         InitEnvironment();
     }
 
@@ -19,9 +79,74 @@ namespace android
         if (!m_state)
             return;
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplAndroid_NewFrame();
+        // Other overlays may build their frames on this thread too, with their own ImGui and,
+        // drawing here, EGL contexts.
+        ImGui::SetCurrentContext(m_imguiContext);
+
+        m_profiler.Begin(FrameProfiler::PhaseNewFrame);
+
+        if (m_options.renderThread && m_renderThreadFailed.load(std::memory_order_acquire))
+            FallBackToSerialSubmit();
+        if (m_state && !m_options.renderThread && !EnsureCurrent())
+            UnInitEnvironment();
+        if (m_state)
+            UpdateDisplay();
+        if (!m_state)
+        {
+            m_profiler.End(FrameProfiler::PhaseNewFrame);
+            return;
+        }
+
+        // With a render thread the GL context lives there, device objects are checked before drawing.
+        if (!m_options.renderThread)
+            ImGui_ImplOpenGL3_NewFrame();
+        NewPlatformFrame();
         ImGui::NewFrame();
+
+        m_profiler.End(FrameProfiler::PhaseNewFrame);
+        m_profiler.Begin(FrameProfiler::PhaseBuild);
+    }
+
+    void AImGui::UpdateDisplay()
+    {
+#ifdef __ANDROID__
+        if (!m_nativeWindow || !ANwCreator::PollDisplay(m_options.activity))
+            return;
+
+        auto displayInfo = ANwCreator::GetDisplayInfo(m_options.activity);
+        m_frameScheduler.SetDisplayRefreshRate(displayInfo.refreshRate);
+
+        // A window sized from the display follows it through rotations and resolution changes.
+        // Pre-rotated, a turn by 180 degrees changes the buffer transform but not the size.
+        if (m_followDisplaySize && (displayInfo.width != m_screenWidth || displayInfo.height != m_screenHeight ||
+                                    GetPreRotation(displayInfo.theta) != m_preRotation))
+            RecreateSurface(-1, -1);
+#endif
+    }
+
+    void AImGui::NewPlatformFrame()
+    {
+        // Display size and time step are fed here rather than by ImGui_ImplAndroid_NewFrame(),
+        // which tracks a single global window while every overlay has its own.
+        auto &io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(static_cast<float>(m_screenWidth), static_cast<float>(m_screenHeight));
+        // ImGui rasterizes glyphs at the framebuffer scale and would bake them again for every
+        // resolution step. The buffer scale only reaches the draw data, in EndFrame().
+        io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
+#ifdef __ANDROID__
+        // A fitted or scaled window is smaller than the display, ImGui then keeps working in display
+        // space. So does it with a pre-rotated one, whose buffers are already turned: the renderer
+        // swaps the sides itself.
+        if (m_nativeWindow && !m_options.fitSurface && !m_options.dynamicResolution && 0 == m_preRotation)
+            io.DisplaySize = ImVec2(static_cast<float>(ANativeWindow_getWidth(m_nativeWindow)),
+                                    static_cast<float>(ANativeWindow_getHeight(m_nativeWindow)));
+#endif
+
+        int64_t now = SteadyFrameClock::Instance().Now();
+        io.DeltaTime = m_lastFrameTime > 0 ? static_cast<float>(now - m_lastFrameTime) * 1e-9f : 1.0f / 60.0f;
+        if (io.DeltaTime <= 0.0f)
+            io.DeltaTime = 1e-6f;
+        m_lastFrameTime = now;
     }
 
     void AImGui::EndFrame()
@@ -29,37 +154,641 @@ namespace android
         if (!m_state)
             return;
 
+        ImGui::SetCurrentContext(m_imguiContext);
+
+        m_profiler.End(FrameProfiler::PhaseBuild);
+
+        m_profiler.Begin(FrameProfiler::PhaseRender);
         ImGui::Render();
+        m_profiler.End(FrameProfiler::PhaseRender);
+
+        ImDrawData *drawData = ImGui::GetDrawData();
+        if (m_options.fitSurface && m_nativeWindow)
+            FitSurface(drawData);
+        else if (m_options.cropToContent && m_nativeWindow)
+            CropToContent(drawData);
+        if (m_nativeWindow && (m_options.fitSurface || m_options.dynamicResolution))
+            drawData->FramebufferScale = m_framebufferScale;
+
+        // Only hashed when something depends on whether the frame changed.
+        bool changed = true;
+        if (m_options.skipUnchangedFrames || m_options.idleFrameRate > 0.0f)
+            changed = m_drawDataFingerprint.Update(drawData);
+
+        // Anything moving on screen counts as activity, so animations keep the full rate too.
+        if (m_options.idleFrameRate > 0.0f && (changed || HasInput(ImGui::GetIO())))
+            m_frameScheduler.NotifyActivity();
+        UpdateFrameRateHint();
+        m_swapInterval.store(m_frameScheduler.GetSwapInterval(), std::memory_order_relaxed);
+
+        if (m_options.skipUnchangedFrames && !changed)
+        {
+            ++m_frameStats.framesSkipped;
+#ifdef __ANDROID__
+            // No buffer to go with, but a frame rate change still has to reach the compositor.
+            if (m_nativeWindow && !ANwCreator::Apply(m_options.activity, m_nativeWindow))
+                LogError("Surface transaction failed");
+#endif
+        }
+        else if (m_options.renderThread)
+        {
+            PublishFrame(drawData);
+        }
+        else
+        {
+            // Another overlay may have drawn on this thread since BeginFrame().
+            if (!EnsureCurrent())
+            {
+                UnInitEnvironment();
+                return;
+            }
+
+            const int64_t handOffTime = SteadyFrameClock::Instance().Now();
+            SubmitFrame(drawData);
+            RecordFrameLatency(handOffTime);
+            ++m_frameStats.framesSubmitted;
+        }
+
+        if (m_options.dynamicResolution && m_nativeWindow)
+            UpdateResolution();
+
+        if (0 == m_startupStats.firstFrameTime)
+            m_startupStats.firstFrameTime = SteadyFrameClock::Instance().Now() - m_startupStats.start;
+
+        m_frameScheduler.WaitForNextFrame();
+    }
+
+    int32_t AImGui::GetPreRotation(int32_t theta) const
+    {
+        // Only a window covering the display at full resolution is worth turning, fitted or
+        // scaled surfaces are moved and resized by the compositor anyway.
+        if (!m_options.preRotate || !m_followDisplaySize || m_options.fitSurface || m_options.dynamicResolution)
+            return 0;
+        return (theta / 90) & 3;
+    }
+
+    void AImGui::UpdateFrameRateHint()
+    {
+#ifdef __ANDROID__
+        const float frameRate = m_frameScheduler.GetContentFrameRate();
+        if (!m_nativeWindow || frameRate == m_frameRateHint)
+            return;
+
+        // Fails only when the layer cannot vote at all (before API 30), which a retry every
+        // frame would not change.
+        ANwCreator::SetFrameRate(m_nativeWindow, frameRate);
+        m_frameRateHint = frameRate;
+#endif
+    }
+
+    void AImGui::FitSurface(ImDrawData *drawData)
+    {
+        const ImVec2 displayPos = drawData->DisplayPos;
+        if (m_surfaceFitter.Update(ComputeContentBounds(drawData)) && !ApplySurfaceGeometry())
+        {
+            LogError("Surface resize failed, keeping the full display");
+            m_options.fitSurface = false;
+            m_surfaceFitter.SetDisplaySize(m_screenWidth, m_screenHeight);
+            return;
+        }
+
+        // Only the part of the display covered by the surface gets rendered.
+        const SurfaceFitter::Rect &rect = m_surfaceFitter.GetRect();
+        drawData->DisplayPos = ImVec2(displayPos.x + static_cast<float>(rect.x), displayPos.y + static_cast<float>(rect.y));
+        drawData->DisplaySize = ImVec2(static_cast<float>(rect.width), static_cast<float>(rect.height));
+    }
+
+    void AImGui::CropToContent(const ImDrawData *drawData)
+    {
+        // Same hysteresis as fitSurface, but only the crop moves: no buffer reallocation, and
+        // the compositor skips everything outside instead of blending transparent pixels.
+        if (!m_cropFitter.Update(ComputeContentBounds(drawData)))
+            return;
+
+        const SurfaceFitter::Rect &rect = m_cropFitter.GetRect();
+        m_layout.cropLeft = static_cast<int32_t>(floorf(static_cast<float>(rect.x) * m_framebufferScale.x));
+        m_layout.cropTop = static_cast<int32_t>(floorf(static_cast<float>(rect.y) * m_framebufferScale.y));
+        m_layout.cropRight = static_cast<int32_t>(ceilf(static_cast<float>(rect.x + rect.width) * m_framebufferScale.x));
+        m_layout.cropBottom = static_cast<int32_t>(ceilf(static_cast<float>(rect.y + rect.height) * m_framebufferScale.y));
+
+        // With a render thread the crop goes out with this frame's snapshot.
+        if (!m_options.renderThread)
+            ApplyLayout(m_layout);
+    }
+
+    bool AImGui::ApplySurfaceGeometry()
+    {
+        SurfaceFitter::Rect rect = m_options.fitSurface ? m_surfaceFitter.GetRect() : SurfaceFitter::Rect{0, 0, m_screenWidth, m_screenHeight};
+        float scale = m_options.dynamicResolution ? m_resolutionScaler.GetScale() : 1.0f;
+        int32_t bufferWidth = std::max(1, static_cast<int32_t>(lroundf(static_cast<float>(rect.width) * scale)));
+        int32_t bufferHeight = std::max(1, static_cast<int32_t>(lroundf(static_cast<float>(rect.height) * scale)));
+
+        // The GL thread may still be drawing an older frame into buffers of the old size. It
+        // resizes the layer itself, right before the first frame built for the new geometry.
+        const SurfaceLayout previous = m_layout;
+        m_layout.x = rect.x;
+        m_layout.y = rect.y;
+        m_layout.width = rect.width;
+        m_layout.height = rect.height;
+        m_layout.bufferWidth = bufferWidth;
+        m_layout.bufferHeight = bufferHeight;
+        if (!m_options.renderThread && !ApplyLayout(m_layout))
+        {
+            m_layout = previous;
+            return false;
+        }
+
+        m_framebufferScale = ImVec2(static_cast<float>(bufferWidth) / static_cast<float>(rect.width),
+                                    static_cast<float>(bufferHeight) / static_cast<float>(rect.height));
+        return true;
+    }
+
+    bool AImGui::ApplyLayout(const SurfaceLayout &layout)
+    {
+        bool applied = true;
+#ifdef __ANDROID__
+        if (!layout.HasSameGeometry(m_appliedLayout))
+            applied = ANwCreator::SetGeometry(m_nativeWindow, layout.x, layout.y, layout.width, layout.height,
+                                              layout.bufferWidth, layout.bufferHeight);
+        if (!layout.HasSameCrop(m_appliedLayout))
+            applied = ANwCreator::SetCrop(m_nativeWindow, layout.cropLeft, layout.cropTop, layout.cropRight, layout.cropBottom) && applied;
+#endif
+
+        // A change that failed is not retried with every frame.
+        m_appliedLayout = layout;
+        return applied;
+    }
+
+    void AImGui::ResetLayout()
+    {
+        // A fresh layer covers the display with buffers of its size and no crop.
+        m_layout = SurfaceLayout{0, 0, m_screenWidth, m_screenHeight, m_screenWidth, m_screenHeight};
+        m_appliedLayout = m_layout;
+    }
+
+    void AImGui::UpdateResolution()
+    {
+        // The period moves with the display refresh rate and the idle rate.
+        m_resolutionScaler.SetBudget(static_cast<int64_t>(static_cast<double>(m_frameScheduler.GetFramePeriod()) * m_options.resolutionBudget));
+        if (!m_resolutionScaler.Update(m_frameCost.load(std::memory_order_relaxed)))
+            return;
+
+        if (!ApplySurfaceGeometry())
+        {
+            LogError("Resolution change failed, dynamic resolution disabled");
+            m_options.dynamicResolution = false;
+            return;
+        }
+
+        LogInfo("Resolution scale %.2f", m_resolutionScaler.GetScale());
+    }
+
+    void AImGui::SubmitFrame(ImDrawData *drawData)
+    {
+        int64_t drawStart = SteadyFrameClock::Instance().Now();
+
+        m_profiler.Begin(FrameProfiler::PhaseDraw);
+        m_profiler.BeginGpu();
+        bool partial = m_partialUpdate && RenderDamage(drawData);
+        if (!partial)
+        {
+            // The owned-context renderer leaves the scissor test on.
+            glDisable(GL_SCISSOR_TEST);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(drawData);
+        }
+        m_profiler.EndGpu();
+        m_profiler.End(FrameProfiler::PhaseDraw);
+
+        // What a lower resolution can save. Not the swap, which waits for vsync. GPU results
+        // arrive a few frames late, fine for the averaged cost the resolution scaler wants.
+        int64_t gpuTime = m_profiler.HasGpuTimer() ? m_profiler.GetLatest(FrameProfiler::PhaseGpu) : 0;
+        m_frameCost.store(gpuTime > 0 ? gpuTime : SteadyFrameClock::Instance().Now() - drawStart, std::memory_order_relaxed);
+
+        m_profiler.Begin(FrameProfiler::PhaseSwap);
+
+        // The swap waits for vsync at the frame interval, the scheduler only sleeps off the rest.
+        const int32_t swapInterval = m_swapInterval.load(std::memory_order_relaxed);
+        if (m_nativeWindow && swapInterval != m_appliedSwapInterval)
+        {
+            if (EGL_TRUE != eglSwapInterval(m_display, swapInterval))
+            {
+                LogError("eglSwapInterval(%d) failed: %d, pacing on the timer only", swapInterval, eglGetError());
+                if (!m_options.renderThread)
+                    m_frameScheduler.SetSwapPaced(false);
+            }
+            m_appliedSwapInterval = swapInterval;
+        }
+
+        if (EGL_NO_SURFACE == m_surface)
+        {
+            glFlush();
+        }
+        else if (partial && m_swapBuffersWithDamage && !m_damageTracker.GetDamage().empty())
+        {
+            // Damage is given in the buffer, turned like the output when pre-rotating.
+            const int fbWidth = static_cast<int>(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+            const int fbHeight = static_cast<int>(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+            m_damageRects.resize(0);
+            for (const ImVec4 &rect : m_damageTracker.GetDamage())
+            {
+                EGLint box[4];
+                ToFramebufferRect(drawData, rect, box);
+                ImGui_ImplOpenGL3_RotateRect(m_preRotation, fbWidth, fbHeight, &box[0], &box[1], &box[2], &box[3]);
+                m_damageRects.push_back(box[0]);
+                m_damageRects.push_back(box[1]);
+                m_damageRects.push_back(box[2]);
+                m_damageRects.push_back(box[3]);
+            }
+            m_swapBuffersWithDamage(m_display, m_surface, m_damageRects.Data, m_damageRects.Size / 4);
+        }
+        else
+        {
+            eglSwapBuffers(m_display, m_surface);
+        }
+#ifdef __ANDROID__
+        if (m_nativeWindow && !ANwCreator::Apply(m_options.activity, m_nativeWindow))
+            LogError("Surface transaction failed");
+#endif
+        m_profiler.End(FrameProfiler::PhaseSwap);
+    }
+
+    void AImGui::InitPartialUpdate()
+    {
+        const char *extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+        if (!extensions)
+            extensions = "";
+
+        // Headless targets are single buffered, their content always survives a frame.
+        m_partialUpdate = m_options.headless || strstr(extensions, "EGL_EXT_buffer_age");
+        if (!m_partialUpdate)
+        {
+            LogInfo("EGL_EXT_buffer_age unavailable, partial update disabled");
+            return;
+        }
+
+        if (strstr(extensions, "EGL_KHR_swap_buffers_with_damage"))
+            m_swapBuffersWithDamage = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+        else if (strstr(extensions, "EGL_EXT_swap_buffers_with_damage"))
+            m_swapBuffersWithDamage = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+
+    bool AImGui::RenderDamage(ImDrawData *drawData)
+    {
+        m_damageTracker.Update(drawData);
+
+        EGLint bufferAge = 1;
+        if (!m_options.headless && EGL_TRUE != eglQuerySurface(m_display, m_surface, EGL_BUFFER_AGE_EXT, &bufferAge))
+            bufferAge = 0;
+
+        ImVec4 rect;
+        if (!m_damageTracker.GetRepaintRect(bufferAge, &rect))
+            return false;
+
+        // The back buffer already holds this frame.
+        if (DamageTracker::IsEmpty(rect))
+            return true;
+
+        EGLint box[4];
+        ToFramebufferRect(drawData, rect, box);
+
+        EGLint scissor[4] = {box[0], box[1], box[2], box[3]};
+        ImGui_ImplOpenGL3_RotateRect(m_preRotation, static_cast<int>(drawData->DisplaySize.x * drawData->FramebufferScale.x),
+                                     static_cast<int>(drawData->DisplaySize.y * drawData->FramebufferScale.y),
+                                     &scissor[0], &scissor[1], &scissor[2], &scissor[3]);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
         glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        eglSwapBuffers(m_display, m_surface);
+        glDisable(GL_SCISSOR_TEST);
+
+        // Clip every command to the repainted area (snapped to whole pixels), so nothing
+        // blends twice over pixels kept from the previous frame. Commands clipped away
+        // entirely are skipped by the backend.
+        const ImVec2 &pos = drawData->DisplayPos;
+        const ImVec2 &scale = drawData->FramebufferScale;
+        const float fbHeight = drawData->DisplaySize.y * scale.y;
+        ImVec4 clip(pos.x + box[0] / scale.x, pos.y + (fbHeight - box[1] - box[3]) / scale.y,
+                    pos.x + (box[0] + box[2]) / scale.x, pos.y + (fbHeight - box[1]) / scale.y);
+
+        m_savedClipRects.resize(0);
+        for (ImDrawList *drawList : drawData->CmdLists)
+            for (ImDrawCmd &cmd : drawList->CmdBuffer)
+            {
+                m_savedClipRects.push_back(cmd.ClipRect);
+                cmd.ClipRect = ImVec4(fmaxf(cmd.ClipRect.x, clip.x), fmaxf(cmd.ClipRect.y, clip.y),
+                                      fminf(cmd.ClipRect.z, clip.z), fminf(cmd.ClipRect.w, clip.w));
+            }
+
+        ImGui_ImplOpenGL3_RenderDrawData(drawData);
+
+        const ImVec4 *saved = m_savedClipRects.Data;
+        for (ImDrawList *drawList : drawData->CmdLists)
+            for (ImDrawCmd &cmd : drawList->CmdBuffer)
+                cmd.ClipRect = *saved++;
+
+        return true;
+    }
+
+    void AImGui::PublishFrame(ImDrawData *drawData)
+    {
+        DrawDataSnapshot &snapshot = m_snapshots.Back();
+        snapshot.Capture(drawData, ++m_publishedFrameIndex, SteadyFrameClock::Instance().Now());
+        snapshot.SetLayout(m_layout);
+
+        bool hasTextureUpdates = snapshot.HasTextureUpdates();
+        if (!m_snapshots.Publish())
+            ++m_frameStats.framesDropped;
+        ++m_frameStats.framesSubmitted;
+
+        // Texture data is shared with the ImGui context. Let the GL thread finish uploading
+        // before the next NewFrame() touches it again, this only happens when glyphs get baked.
+        if (hasTextureUpdates)
+        {
+            uint64_t rendered = m_renderedFrameIndex.load(std::memory_order_acquire);
+            while (rendered < m_publishedFrameIndex)
+            {
+                m_renderedFrameIndex.wait(rendered, std::memory_order_acquire);
+                rendered = m_renderedFrameIndex.load(std::memory_order_acquire);
+            }
+        }
+    }
+
+    void AImGui::RecordFrameLatency(int64_t handOffTime)
+    {
+        int64_t latency = SteadyFrameClock::Instance().Now() - handOffTime;
+        m_renderThreadStats.lastLatency.store(latency, std::memory_order_relaxed);
+        if (latency > m_renderThreadStats.maxLatency.load(std::memory_order_relaxed))
+            m_renderThreadStats.maxLatency.store(latency, std::memory_order_relaxed);
+        m_renderThreadStats.framesRendered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AImGui::StartRenderThread()
+    {
+        // The context can only be current on one thread, hand it over to the GL thread.
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        m_snapshots.Reset();
+        m_publishedFrameIndex = 0;
+        m_renderedFrameIndex.store(0, std::memory_order_relaxed);
+        m_renderThreadFailed.store(false, std::memory_order_relaxed);
+        m_renderThread = std::thread(&AImGui::RenderThreadMain, this);
+    }
+
+    bool AImGui::StopRenderThread()
+    {
+        if (!m_renderThread.joinable())
+            return true;
+
+        m_snapshots.Stop();
+        m_renderThread.join();
+
+        return EGL_TRUE == eglMakeCurrent(m_display, m_surface, m_surface, m_context);
+    }
+
+    void AImGui::FallBackToSerialSubmit()
+    {
+        // Frames published to it were never drawn. All but the last one replaced each other
+        // in the pending slot and were counted as dropped already.
+        LogError("Render thread has no context, submitting frames on this thread");
+        if (m_publishedFrameIndex > 0)
+            ++m_frameStats.framesDropped;
+        m_options.renderThread = false;
+        if (!StopRenderThread())
+        {
+            LogError("eglMakeCurrent failed: %d", eglGetError());
+            UnInitEnvironment();
+            return;
+        }
+        m_frameScheduler.SetSwapPaced(nullptr != m_nativeWindow);
+    }
+
+    void AImGui::RenderThreadMain()
+    {
+        if (EGL_TRUE != eglMakeCurrent(m_display, m_surface, m_surface, m_context))
+        {
+            LogError("eglMakeCurrent failed on render thread: %d", eglGetError());
+            m_renderThreadFailed.store(true, std::memory_order_release);
+            m_renderedFrameIndex.store(UINT64_MAX, std::memory_order_release);
+            m_renderedFrameIndex.notify_all();
+            return;
+        }
+
+        // The OpenGL3 backend finds its state through the current ImGui context.
+        ImGui::SetCurrentContext(m_imguiContext);
+
+        while (m_snapshots.Wait())
+        {
+            if (!m_snapshots.Acquire())
+                continue;
+
+            DrawDataSnapshot &snapshot = m_snapshots.Front();
+
+            // Every snapshot carries the whole layout, frames dropped in between lose nothing.
+            if (m_nativeWindow && !ApplyLayout(snapshot.GetLayout()))
+                LogError("Surface layout change failed");
+
+            ImGui_ImplOpenGL3_NewFrame();
+            SubmitFrame(snapshot.Get());
+            RecordFrameLatency(snapshot.GetTimestamp());
+
+            m_renderedFrameIndex.store(snapshot.GetFrameIndex(), std::memory_order_release);
+            m_renderedFrameIndex.notify_all();
+        }
+
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        // Unblock a UI thread still waiting on texture uploads.
+        m_renderedFrameIndex.store(UINT64_MAX, std::memory_order_release);
+        m_renderedFrameIndex.notify_all();
     }
 
     bool AImGui::InitEnvironment()
     {
-        if (!m_options.activity)
+        const int64_t start = SteadyFrameClock::Instance().Now();
+        m_startupStats = StartupStats{};
+
+        // The JNI window, the EGL display and context and the ImGui context with its font atlas
+        // don't depend on each other and are set up concurrently. Making the context current and
+        // the GL backend stay on this thread, which renders from now on. Threads are started in
+        // the order stages are added: spawning one can stall on the loader lock while EGL loads
+        // its driver, so the display comes after the stages that don't load libraries.
+        StartupGraph graph;
+        StartupGraph::Stage imgui = graph.Add("imgui", [this]
+                                              { return InitImGuiContext(); });
+        StartupGraph::Stage display, surface;
+        if (m_options.headless)
         {
-            LogError("Invalid activity");
+            display = graph.Add("display", [this]
+                                { return InitHeadlessDisplay(); });
+            surface = graph.Add("surface", [this]
+                                { return m_headlessSurfaceless || CreateHeadlessSurface(); }, {display});
+        }
+        else
+        {
+            StartupGraph::Stage window = graph.Add("window", [this]
+                                                   { return CreateNativeWindow(m_options.width, m_options.height); });
+            display = graph.Add("display", [this]
+                                { return InitWindowDisplay(); });
+            surface = graph.Add("surface", [this]
+                                { return CreateEglWindowSurface(); }, {display, window});
+        }
+        StartupGraph::Stage context = graph.Add("context", [this]
+                                                { return CreateContext(); }, {display});
+        StartupGraph::Stage current = graph.Add("current", [this]
+                                                { return MakeCurrent(); }, {surface, context}, true);
+        StartupGraph::Stage backend = graph.Add("backend", [this]
+                                                { return InitBackend(); }, {current, imgui}, true);
+
+        // With a single core the worker threads only add their own startup and switches to
+        // the stages, the serial order is faster.
+        m_startupStats.parallel = m_options.parallelStartup && std::thread::hardware_concurrency() > 1;
+        const bool started = graph.Run(m_startupStats.parallel);
+
+        m_startupStats.stageCount = graph.GetStageCount();
+        for (int32_t i = 0; i < graph.GetStageCount(); ++i)
+            m_startupStats.stages[i] = graph.GetTiming(i);
+        m_startupStats.stagesTime = graph.GetSerialTime();
+        m_startupStats.programCache = m_programCache.GetStats();
+
+        if (!started)
+        {
+            // UnInitEnvironment() shuts the GL backend down along with the ImGui context.
+            if (m_imguiContext && !graph.Succeeded(backend))
+            {
+                ImGui::DestroyContext(m_imguiContext);
+                m_imguiContext = nullptr;
+            }
+            UnInitEnvironment();
             return false;
         }
 
-        ANwCreator::CreateOptions createOptions;
-        createOptions.name = "AImGui";
-        createOptions.skipScreenshot = m_options.skipScreenshot;
+        m_profiler.SetEnabled(m_options.profiler);
+        // Dynamic resolution sizes the buffers after GPU time when it can get it.
+        if (((m_options.profiler && m_options.profileGpu) || m_options.dynamicResolution) && !m_profiler.InitGpuTimer())
+            LogInfo("EXT_disjoint_timer_query unavailable, GPU timing disabled");
 
-        m_nativeWindow = ANwCreator::Create(m_options.activity, createOptions);
-        if (!m_nativeWindow)
+        if (m_options.partialUpdate)
+            InitPartialUpdate();
+
+        m_surfaceFitter.SetDisplaySize(m_screenWidth, m_screenHeight);
+        m_cropFitter.SetDisplaySize(m_screenWidth, m_screenHeight);
+        ResetLayout();
+
+        m_resolutionScaler.SetRange(m_options.minResolutionScale, 1.0f);
+
+        // The GL thread presents on its own, the UI thread can't see its swaps block.
+        m_frameScheduler.SetSwapPaced(nullptr != m_nativeWindow && !m_options.renderThread);
+        if (m_options.renderThread)
+            StartRenderThread();
+
+        m_startupStats.start = start;
+        m_startupStats.initTime = SteadyFrameClock::Instance().Now() - start;
+        for (int32_t i = 0; i < m_startupStats.stageCount; ++i)
         {
-            LogError("ANativeWindow create failed");
+            const StartupGraph::Timing &timing = m_startupStats.stages[i];
+            LogInfo("Startup %-8s %7.2f -> %7.2f ms%s", timing.name, static_cast<double>(timing.start) * 1e-6,
+                    static_cast<double>(timing.end) * 1e-6, timing.worker ? " (worker)" : "");
+        }
+        LogInfo("Startup took %.2f ms, stages %.2f ms", static_cast<double>(m_startupStats.initTime) * 1e-6,
+                static_cast<double>(m_startupStats.stagesTime) * 1e-6);
+
+        return (m_state = true);
+    }
+
+    bool AImGui::InitImGuiContext()
+    {
+        IMGUI_CHECKVERSION();
+
+        m_imguiContext = ImGui::CreateContext();
+        ImGui::SetCurrentContext(m_imguiContext);
+
+        auto &io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+
+        ImGui::StyleColorsDark();
+        ImGui::GetStyle().ScaleAllSizes(3.0f);
+
+        ImFontConfig fontConfig;
+        fontConfig.SizePixels = 22.0f;
+        ImFont *font = io.Fonts->AddFontDefault(&fontConfig);
+
+        // The GL backend declares dynamic textures as well. Declared here already, the atlas is
+        // built and the printable ASCII glyphs rasterized on this thread instead of during the
+        // first NewFrame(); the texture itself is still uploaded by the first draw.
+        io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+        ImFontAtlasBuildMain(io.Fonts);
+        ImFontBaked *baked = font->GetFontBaked(font->LegacySize);
+        for (ImWchar c = 0x20; c < 0x7F; ++c)
+            baked->FindGlyph(c);
+
+        return true;
+    }
+
+    bool AImGui::InitBackend()
+    {
+        ImGui::SetCurrentContext(m_imguiContext);
+
+#ifdef __ANDROID__
+        if (m_nativeWindow)
+            ImGui_ImplAndroid_Init(m_nativeWindow);
+#endif
+        if (!ImGui_ImplOpenGL3_Init("#version 300 es"))
+        {
+            LogError("ImGui_ImplOpenGL3_Init failed");
+#ifdef __ANDROID__
+            if (m_nativeWindow)
+                ImGui_ImplAndroid_Shutdown();
+#endif
             return false;
         }
+        ImGui_ImplOpenGL3_SetFramebufferRotation(m_preRotation);
 
-        ANativeWindow_acquire(m_nativeWindow);
+        // The shader program is built here rather than by the first NewFrame(), from the
+        // cached binary when the driver still accepts it.
+        std::string programCachePath = m_options.programCachePath ? m_options.programCachePath : "";
+#ifdef __ANDROID__
+        if (!m_options.programCachePath && m_options.activity && m_options.activity->internalDataPath)
+            programCachePath = std::string(m_options.activity->internalDataPath) + "/AImGui.program";
+#endif
+        m_programCache.SetPath(programCachePath);
+        m_programCache.Attach();
+        const bool created = ImGui_ImplOpenGL3_CreateDeviceObjects();
+        ImGui_ImplOpenGL3_SetProgramCache(nullptr);
+        if (!created)
+        {
+            LogError("ImGui_ImplOpenGL3_CreateDeviceObjects failed");
+            ImGui_ImplOpenGL3_Shutdown();
+#ifdef __ANDROID__
+            if (m_nativeWindow)
+                ImGui_ImplAndroid_Shutdown();
+#endif
+            return false;
+        }
 
-        auto displayInfo = ANwCreator::GetDisplayInfo(m_options.activity);
-        m_screenWidth = displayInfo.width;
-        m_screenHeight = displayInfo.height;
+        // Nothing else draws into this context, so the renderer may keep its state between frames.
+        if (m_options.ownedContext)
+        {
+            ImGui_ImplOpenGL3_SetOwnedContext(true, [](const char *name)
+                                              { return reinterpret_cast<void *>(eglGetProcAddress(name)); });
+            LogInfo("Owned GL context, %s", ImGui_ImplOpenGL3_HasBaseVertex() ? "base vertex drawing" : "no base vertex");
+        }
+
+        const ProgramBinaryCache::Stats &cacheStats = m_programCache.GetStats();
+        if (cacheStats.loaded)
+            LogInfo("Shader program loaded from cache in %.2f ms, %.2f ms saved", static_cast<double>(cacheStats.loadTime) * 1e-6,
+                    static_cast<double>(cacheStats.GetTimeSaved()) * 1e-6);
+        else if (cacheStats.saved)
+            LogInfo("Shader program built in %.2f ms and cached%s", static_cast<double>(cacheStats.buildTime) * 1e-6,
+                    cacheStats.rejected ? ", the old binary was stale" : "");
 
+        glViewport(0, 0, m_screenWidth, m_screenHeight);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        return true;
+    }
+
+    bool AImGui::InitWindowDisplay()
+    {
+#ifdef __ANDROID__
         m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
         if (EGL_NO_DISPLAY == m_display)
         {
@@ -99,8 +828,67 @@ namespace android
             return false;
         }
 
+        m_config = config;
+        return true;
+#else
+        LogError("Window surfaces need an Android activity, use Options::headless");
+        return false;
+#endif
+    }
+
+    bool AImGui::CreateWindowSurface(int32_t width, int32_t height)
+    {
+        return CreateNativeWindow(width, height) && CreateEglWindowSurface();
+    }
+
+    bool AImGui::CreateNativeWindow(int32_t width, int32_t height)
+    {
+#ifdef __ANDROID__
+        if (!m_options.activity)
+        {
+            LogError("Invalid activity");
+            return false;
+        }
+
+        ANwCreator::CreateOptions createOptions;
+        createOptions.name = "AImGui";
+        createOptions.width = width;
+        createOptions.height = height;
+        createOptions.skipScreenshot = m_options.skipScreenshot;
+        createOptions.layer = m_options.layer;
+        createOptions.flags = static_cast<ANwCreator::SurfaceControlFlags>(m_options.surfaceFlags);
+
+        m_nativeWindow = ANwCreator::Create(m_options.activity, createOptions);
+        if (!m_nativeWindow)
+        {
+            LogError("ANativeWindow create failed");
+            return false;
+        }
+
+        ANativeWindow_acquire(m_nativeWindow);
+
+        auto displayInfo = ANwCreator::GetDisplayInfo(m_options.activity);
+        m_screenWidth = width > 0 ? width : displayInfo.width;
+        m_screenHeight = height > 0 ? height : displayInfo.height;
+        m_followDisplaySize = width <= 0 && height <= 0;
+        m_frameRateHint = 0.0f; // a new layer starts without a vote
+        m_preRotation = GetPreRotation(displayInfo.theta);
+
+        m_frameScheduler.SetDisplayRefreshRate(displayInfo.refreshRate);
+        m_frameScheduler.SetTargetFrameRate(m_options.targetFrameRate);
+        return true;
+#else
+        (void)width;
+        (void)height;
+        return false;
+#endif
+    }
+
+    bool AImGui::CreateEglWindowSurface()
+    {
+#ifdef __ANDROID__
         EGLint format;
-        if (EGL_TRUE != eglGetConfigAttrib(m_display, config, EGL_NATIVE_VISUAL_ID, &format))
+        if (EGL_TRUE != eglGetConfigAttrib(m_display, m_config, EGL_NATIVE_VISUAL_ID, &format))
         {
             LogError("eglGetConfigAttrib failed: %d", eglGetError());
             return false;
@@ -108,61 +896,352 @@ namespace android
 
         ANativeWindow_setBuffersGeometry(m_nativeWindow, 0, 0, format);
 
-        m_surface = eglCreateWindowSurface(m_display, config, m_nativeWindow, nullptr);
+        // Before the EGL surface exists, so its very first buffer is already turned.
+        if (m_preRotation && !ANwCreator::SetPreRotation(m_nativeWindow, m_preRotation))
+        {
+            LogError("Pre-rotation failed, the compositor rotates instead");
+            m_preRotation = 0;
+        }
+
+        return CreateEglSurface();
+#else
+        return false;
+#endif
+    }
+
+    bool AImGui::CreateEglSurface()
+    {
+#ifdef __ANDROID__
+        m_surface = eglCreateWindowSurface(m_display, m_config, m_nativeWindow, nullptr);
         if (EGL_NO_SURFACE == m_surface)
         {
             LogError("eglCreateWindowSurface failed: %d", eglGetError());
             return false;
         }
 
-        const EGLint contextAttribs[] = {
-            EGL_CONTEXT_CLIENT_VERSION, 3,
+        // The swap interval belongs to the surface.
+        m_appliedSwapInterval = 0;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool AImGui::ResizeNativeWindow(int32_t width, int32_t height)
+    {
+#ifdef __ANDROID__
+        auto displayInfo = ANwCreator::GetDisplayInfo(m_options.activity);
+        m_screenWidth = width > 0 ? width : displayInfo.width;
+        m_screenHeight = height > 0 ? height : displayInfo.height;
+        m_followDisplaySize = width <= 0 && height <= 0;
+        m_preRotation = GetPreRotation(displayInfo.theta);
+
+        // Back to full size, unscaled and uncropped, like a new layer. The producer side takes
+        // the new size right away, the layer follows with the first frame.
+        if (!ANwCreator::SetGeometry(m_nativeWindow, 0, 0, m_screenWidth, m_screenHeight) ||
+            !ANwCreator::SetCrop(m_nativeWindow, 0, 0, 0, 0))
+            return false;
+
+        // Also when it drops to 0, the window may still carry the previous transform.
+        if (!ANwCreator::SetPreRotation(m_nativeWindow, m_preRotation) && m_preRotation)
+        {
+            LogError("Pre-rotation failed, the compositor rotates instead");
+            m_preRotation = 0;
+            ANwCreator::SetPreRotation(m_nativeWindow, 0);
+        }
+        return true;
+#else
+        (void)width;
+        (void)height;
+        return false;
+#endif
+    }
+
+    bool AImGui::InitHeadlessDisplay()
+    {
+        m_screenWidth = m_options.width > 0 ? m_options.width : 1280;
+        m_screenHeight = m_options.height > 0 ? m_options.height : 720;
+
+        m_frameScheduler.SetDisplayRefreshRate(60.0f);
+        m_frameScheduler.SetTargetFrameRate(m_options.targetFrameRate);
+
+        // Mesa's surfaceless platform needs neither a window system nor a GPU (llvmpipe).
+        const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        {
+            auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (getPlatformDisplay)
+                m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+
+        if (EGL_NO_DISPLAY == m_display)
+            m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        if (EGL_NO_DISPLAY == m_display)
+        {
+            LogError("eglGetDisplay failed: %d", eglGetError());
+            return false;
+        }
+
+        if (EGL_TRUE != eglInitialize(m_display, nullptr, nullptr))
+        {
+            LogError("eglInitialize failed: %d", eglGetError());
+            return false;
+        }
+
+        EGLint numConfig = 0;
+        EGLConfig config{};
+        EGLint attribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
             EGL_NONE};
 
-        m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttribs);
-        if (EGL_NO_CONTEXT == m_context)
+        bool pbuffer = EGL_TRUE == eglChooseConfig(m_display, attribs, &config, 1, &numConfig) && numConfig > 0;
+        if (!pbuffer)
         {
-            LogError("eglCreateContext failed: %d", eglGetError());
+            const char *extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+            if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context"))
+            {
+                LogError("Headless init failed: neither pbuffer nor surfaceless contexts are supported");
+                return false;
+            }
+
+            attribs[1] = 0;
+            if (EGL_TRUE != eglChooseConfig(m_display, attribs, &config, 1, &numConfig) || 0 == numConfig)
+            {
+                LogError("eglChooseConfig failed: %d", eglGetError());
+                return false;
+            }
+        }
+
+        m_config = config;
+        m_headlessSurfaceless = !pbuffer;
+        return true;
+    }
+
+    bool AImGui::CreateHeadlessSurface()
+    {
+        const EGLint surfaceAttribs[] = {
+            EGL_WIDTH, m_screenWidth,
+            EGL_HEIGHT, m_screenHeight,
+            EGL_NONE};
+
+        m_surface = eglCreatePbufferSurface(m_display, m_config, surfaceAttribs);
+        if (EGL_NO_SURFACE == m_surface)
+        {
+            LogError("eglCreatePbufferSurface failed: %d", eglGetError());
             return false;
         }
+        return true;
+    }
 
-        if (EGL_TRUE != eglMakeCurrent(m_display, m_surface, m_surface, m_context))
+    bool AImGui::UpdateHeadlessFramebuffer()
+    {
+        if (!m_headlessFramebuffer)
         {
-            LogError("eglMakeCurrent failed: %d", eglGetError());
+            glGenRenderbuffers(1, &m_headlessColorBuffer);
+            glGenFramebuffers(1, &m_headlessFramebuffer);
+        }
+
+        glBindRenderbuffer(GL_RENDERBUFFER, m_headlessColorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_screenWidth, m_screenHeight);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_headlessFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_headlessColorBuffer);
+
+        if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_FRAMEBUFFER))
+        {
+            LogError("Headless framebuffer incomplete");
             return false;
         }
+        return true;
+    }
 
-        IMGUI_CHECKVERSION();
+    void AImGui::DestroySurface()
+    {
+        if (EGL_NO_SURFACE != m_surface)
+        {
+            eglDestroySurface(m_display, m_surface);
+            m_surface = EGL_NO_SURFACE;
+        }
 
-        m_imguiContext = ImGui::CreateContext();
+#ifdef __ANDROID__
+        if (nullptr != m_nativeWindow)
+        {
+            ANativeWindow_release(m_nativeWindow);
+            ANwCreator::Destroy(m_options.activity, m_nativeWindow);
+            m_nativeWindow = nullptr;
+        }
+#endif
+    }
 
-        auto &io = ImGui::GetIO();
-        io.IniFilename = nullptr;
+    bool AImGui::RecreateSurface(int32_t width, int32_t height, bool replaceWindow)
+    {
+        if (!m_state)
+            return false;
 
-        ImGui::StyleColorsDark();
-        ImGui::GetStyle().ScaleAllSizes(3.0f);
+        int64_t start = SteadyFrameClock::Instance().Now();
+        ImGui::SetCurrentContext(m_imguiContext);
 
-        ImFontConfig fontConfig;
-        fontConfig.SizePixels = 22.0f;
-        io.Fonts->AddFontDefault(&fontConfig);
+        // The GL thread has to let go of the context, it comes back to this thread.
+        bool renderThread = m_renderThread.joinable();
+        StopRenderThread();
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
-        ImGui_ImplAndroid_Init(m_nativeWindow);
-        ImGui_ImplOpenGL3_Init("#version 300 es");
+        // Context, programs and textures are untouched, only the drawable is replaced.
+        bool created = false;
+        bool resized = false;
+#ifdef __ANDROID__
+        // A layer that still exists is resized in place, saving the JNI round trips of a new
+        // one. Only the EGL surface on its window is created again.
+        if (m_nativeWindow && !replaceWindow && ANwCreator::IsValid(m_nativeWindow))
+        {
+            eglDestroySurface(m_display, m_surface);
+            m_surface = EGL_NO_SURFACE;
+            resized = created = ResizeNativeWindow(width, height) && CreateEglSurface();
+            if (!resized)
+                LogError("Surface resize failed, replacing the window");
+        }
+        if (m_nativeWindow && !resized)
+            ImGui_ImplAndroid_Shutdown();
+#endif
+        if (m_options.headless)
+        {
+            DestroySurface();
+            m_screenWidth = width > 0 ? width : m_screenWidth;
+            m_screenHeight = height > 0 ? height : m_screenHeight;
+            created = m_headlessSurfaceless || CreateHeadlessSurface();
+        }
+        else if (!resized)
+        {
+            DestroySurface();
+            created = CreateWindowSurface(width, height);
+        }
+
+        if (!created || EGL_TRUE != eglMakeCurrent(m_display, m_surface, m_surface, m_context) ||
+            (m_headlessSurfaceless && !UpdateHeadlessFramebuffer()))
+        {
+            LogError("Surface recreation failed: %d", eglGetError());
+            UnInitEnvironment();
+            return false;
+        }
 
+#ifdef __ANDROID__
+        if (m_nativeWindow && !resized)
+            ImGui_ImplAndroid_Init(m_nativeWindow);
+#endif
         glViewport(0, 0, m_screenWidth, m_screenHeight);
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        ImGui_ImplOpenGL3_InvalidateRenderState();
+        ImGui::GetIO().DisplaySize = ImVec2(static_cast<float>(m_screenWidth), static_cast<float>(m_screenHeight));
 
-        return (m_state = true);
+        ImGui_ImplOpenGL3_SetFramebufferRotation(m_preRotation);
+
+        // The new surface starts full size, unscaled, uncropped and without any valid content.
+        m_surfaceFitter.SetDisplaySize(m_screenWidth, m_screenHeight);
+        m_cropFitter.SetDisplaySize(m_screenWidth, m_screenHeight);
+        m_resolutionScaler.Reset();
+        m_framebufferScale = ImVec2(1.0f, 1.0f);
+        ResetLayout();
+        m_drawDataFingerprint.Invalidate();
+        m_damageTracker.Invalidate();
+
+        if (renderThread)
+            StartRenderThread();
+
+        LogInfo("Surface %s at %dx%d in %.2f ms", resized ? "resized" : "recreated", m_screenWidth, m_screenHeight,
+                static_cast<double>(SteadyFrameClock::Instance().Now() - start) * 1e-6);
+        return true;
+    }
+
+    bool AImGui::CreateContext()
+    {
+        const EGLint contextAttribs[] = {
+            EGL_CONTEXT_CLIENT_VERSION, 3,
+            EGL_NONE};
+
+        m_context = eglCreateContext(m_display, m_config, EGL_NO_CONTEXT, contextAttribs);
+        if (EGL_NO_CONTEXT == m_context)
+        {
+            LogError("eglCreateContext failed: %d", eglGetError());
+            return false;
+        }
+        return true;
+    }
+
+    bool AImGui::MakeCurrent()
+    {
+        if (EGL_TRUE != eglMakeCurrent(m_display, m_surface, m_surface, m_context))
+        {
+            LogError("eglMakeCurrent failed: %d", eglGetError());
+            return false;
+        }
+
+        // Surfaceless context: render into an FBO of the same size instead.
+        return !m_headlessSurfaceless || UpdateHeadlessFramebuffer();
+    }
+
+    // Only switches when another overlay's context is current. Everything else lives in the
+    // context itself: the headless FBO stays bound and the backend's state cache, kept per
+    // ImGui context, still matches it.
+    bool AImGui::EnsureCurrent()
+    {
+        if (eglGetCurrentContext() == m_context)
+            return true;
+
+        if (EGL_TRUE != eglMakeCurrent(m_display, m_surface, m_surface, m_context))
+        {
+            LogError("eglMakeCurrent failed: %d", eglGetError());
+            return false;
+        }
+        return true;
     }
 
     void AImGui::UnInitEnvironment()
     {
         m_state = false;
 
+        StopRenderThread();
+
+        if (EGL_NO_CONTEXT != m_context)
+        {
+            m_profiler.ShutdownGpuTimer();
+
+            if (m_headlessFramebuffer)
+            {
+                glDeleteFramebuffers(1, &m_headlessFramebuffer);
+                glDeleteRenderbuffers(1, &m_headlessColorBuffer);
+                m_headlessFramebuffer = m_headlessColorBuffer = 0;
+            }
+        }
+
         if (nullptr != m_imguiContext)
         {
+            ImGui::SetCurrentContext(m_imguiContext);
+            ImGui_ImplOpenGL3_RenderStats render;
+            ImGui_ImplOpenGL3_GetRenderStats(&render);
+            if (render.Frames)
+            {
+                const double frames = static_cast<double>(render.Frames);
+                LogInfo("Renderer per frame: %.1f commands in %.1f draw calls, %.1f scissor and %.1f texture changes",
+                        render.Commands / frames, render.DrawCalls / frames, render.ScissorChanges / frames, render.TextureChanges / frames);
+            }
+            if (render.TextureUploads)
+                LogInfo("Texture uploads: %llu rects, %llu KiB, %llu KiB staged in upload buffers",
+                        static_cast<unsigned long long>(render.TextureUploads), static_cast<unsigned long long>(render.TextureUploadBytes / 1024),
+                        static_cast<unsigned long long>(render.StagedUploadBytes / 1024));
+            ImGui_ImplOpenGL3_StreamStats stream;
+            if (ImGui_ImplOpenGL3_GetStreamStats(&stream) && stream.Frames)
+                LogInfo("Stream buffer %zu KiB: %d frames, grown %d times, %d waited for the GPU, %d fallbacks",
+                        stream.Capacity / 1024, stream.Frames, stream.Grows, stream.Waits, stream.Fallbacks);
             ImGui_ImplOpenGL3_Shutdown();
-            ImGui_ImplAndroid_Shutdown();
+#ifdef __ANDROID__
+            if (m_nativeWindow)
+                ImGui_ImplAndroid_Shutdown();
+#endif
             ImGui::DestroyContext(m_imguiContext);
             m_imguiContext = nullptr;
         }
@@ -177,22 +1256,11 @@ namespace android
                 m_context = EGL_NO_CONTEXT;
             }
 
-            if (EGL_NO_SURFACE != m_surface)
-            {
-                eglDestroySurface(m_display, m_surface);
-                m_surface = EGL_NO_SURFACE;
-            }
+            DestroySurface();
 
             eglTerminate(m_display);
             m_display = EGL_NO_DISPLAY;
         }
-
-        if (nullptr != m_nativeWindow)
-        {
-            ANativeWindow_release(m_nativeWindow);
-            ANwCreator::Destroy(m_options.activity, m_nativeWindow);
-            m_nativeWindow = nullptr;
-        }
     }
 
 } // namespace android
@@ -1,13 +1,32 @@
 #pragma once
 
 #include <imgui.h>
-#include <imgui_impl_android.h>
 #include <imgui_impl_opengl3.h>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES3/gl3.h>
+#ifdef __ANDROID__
+#include <imgui_impl_android.h>
 #include <android/native_window.h>
 #include <android/native_activity.h>
+#else
+struct ANativeWindow;
+struct ANativeActivity;
+#endif
 #include <string>
+#include <thread>
+#include <atomic>
+
+#include "FrameScheduler.hpp"
+#include "DrawDataFingerprint.hpp"
+#include "DrawDataSnapshot.hpp"
+#include "TripleBuffer.hpp"
+#include "FrameProfiler.hpp"
+#include "DamageTracker.hpp"
+#include "SurfaceFitter.hpp"
+#include "ResolutionScaler.hpp"
+#include "StartupGraph.hpp"
+#include "ProgramBinaryCache.hpp"
 
 namespace android
 {
@@ -18,6 +37,57 @@ namespace android
         {
             ANativeActivity *activity = nullptr;
             bool skipScreenshot = false;
+            float targetFrameRate = 0.0f; // 0 follows the display refresh rate
+            float idleFrameRate = 0.0f;   // > 0: drop to this rate after idleTimeout ns without input or visible change
+            int64_t idleTimeout = 500000000;
+            FrameClock *frameClock = nullptr;
+            bool skipUnchangedFrames = false; // skip GL submission and swap when the draw data is identical
+            bool renderThread = false;        // submit and swap on a dedicated GL thread, overlapping UI building
+            bool profiler = false;            // per-phase frame timing, see GetProfiler()
+            bool profileGpu = false;          // adds GPU time when EXT_disjoint_timer_query is available
+            bool headless = false;            // offscreen pbuffer/surfaceless context, no activity needed
+            int32_t width = -1;               // framebuffer (headless) or overlay size, -1 covers the display
+            int32_t height = -1;
+            int32_t layer = 0x7FFFFFFE;       // overlays with a higher layer are drawn on top
+            uint32_t surfaceFlags = 0;        // ANwCreator::SurfaceControlFlags, e.g. eOpaque
+            bool partialUpdate = false;       // repaint only damaged regions, needs EGL_EXT_buffer_age
+            bool fitSurface = false;          // shrink the surface to the bounds of the visible UI
+            bool dynamicResolution = false;   // lower the buffer resolution when frames get expensive
+            float minResolutionScale = 0.5f;
+            float resolutionBudget = 0.5f;    // share of the frame period a frame may cost
+            bool preRotate = false;           // display-sized window: render in the panel's orientation, no compositor rotation
+            bool cropToContent = false;       // crop the layer to the UI bounds (without fitSurface)
+            bool parallelStartup = true;      // overlap independent init stages on 2+ cores, false runs them one after another
+            const char *programCachePath = nullptr; // linked shader program cache, "" disables; Android defaults to internalDataPath
+            bool ownedContext = false;        // the GL context is left to the renderer: no state backup/restore, streamed uploads
+        };
+
+        struct FrameStats
+        {
+            uint64_t framesSubmitted = 0;
+            uint64_t framesSkipped = 0;
+            uint64_t framesDropped = 0; // renderThread: replaced before the GL thread picked them up
+        };
+
+        // Where the time of InitEnvironment() went, in ns.
+        struct StartupStats
+        {
+            StartupGraph::Timing stages[StartupGraph::kMaxStages];
+            int32_t stageCount = 0;
+            int64_t start = 0;          // SteadyFrameClock time InitEnvironment() began
+            int64_t initTime = 0;       // InitEnvironment() wall time
+            int64_t stagesTime = 0;     // sum of the stage times, what a serial startup costs
+            int64_t firstFrameTime = 0; // from start to the end of the first EndFrame(), 0 before
+            bool parallel = false;      // the stages overlapped, see Options::parallelStartup
+            ProgramBinaryCache::Stats programCache;
+        };
+
+        // Written by the GL thread when renderThread is enabled, else by EndFrame() itself.
+        struct RenderThreadStats
+        {
+            std::atomic<uint64_t> framesRendered{0};
+            std::atomic<int64_t> lastLatency{0}; // ns from the end of ImGui::Render() to swap completion
+            std::atomic<int64_t> maxLatency{0};
         };
 
     public:
@@ -28,21 +98,111 @@ namespace android
         void EndFrame();
         void Destroy();
 
+        // Resizes the window after rotation or a display size change, -1 uses the display size.
+        // The layer is kept and only the EGL surface replaced, unless replaceWindow is set or the
+        // layer is gone (surface loss). The EGL context, shaders and textures are always kept.
+        bool RecreateSurface(int32_t width = -1, int32_t height = -1, bool replaceWindow = false);
+
+        bool IsValid() const { return m_state; }
+        FrameScheduler &GetFrameScheduler() { return m_frameScheduler; }
+        const FrameStats &GetFrameStats() const { return m_frameStats; }
+        const RenderThreadStats &GetRenderThreadStats() const { return m_renderThreadStats; }
+        FrameProfiler &GetProfiler() { return m_profiler; }
+        const StartupStats &GetStartupStats() const { return m_startupStats; }
+
     public:
         bool InitEnvironment();
         void UnInitEnvironment();
 
+    private:
+        bool InitImGuiContext();
+        bool InitBackend();
+        bool InitWindowDisplay();
+        bool InitHeadlessDisplay();
+        bool CreateWindowSurface(int32_t width, int32_t height);
+        bool CreateNativeWindow(int32_t width, int32_t height);
+        bool CreateEglWindowSurface();
+        bool CreateEglSurface();
+        bool ResizeNativeWindow(int32_t width, int32_t height);
+        bool CreateHeadlessSurface();
+        bool UpdateHeadlessFramebuffer();
+        void DestroySurface();
+        bool CreateContext();
+        bool MakeCurrent();
+        bool EnsureCurrent();
+        void UpdateDisplay();
+        void NewPlatformFrame();
+        void UpdateFrameRateHint();
+        int32_t GetPreRotation(int32_t theta) const;
+        void CropToContent(const ImDrawData *drawData);
+        void FitSurface(ImDrawData *drawData);
+        bool ApplySurfaceGeometry();
+        bool ApplyLayout(const SurfaceLayout &layout);
+        void ResetLayout();
+        void UpdateResolution();
+
+        void InitPartialUpdate();
+        bool RenderDamage(ImDrawData *drawData);
+        void SubmitFrame(ImDrawData *drawData);
+        void PublishFrame(ImDrawData *drawData);
+        void RecordFrameLatency(int64_t handOffTime);
+        void StartRenderThread();
+        bool StopRenderThread();
+        void FallBackToSerialSubmit();
+        void RenderThreadMain();
+
     private:
         bool m_state = false;
         int32_t m_screenWidth = -1;
         int32_t m_screenHeight = -1;
         Options m_options;
+        FrameScheduler m_frameScheduler;
+        DrawDataFingerprint m_drawDataFingerprint;
+        FrameStats m_frameStats;
+        StartupStats m_startupStats;
+
+        std::thread m_renderThread;
+        TripleBuffer<DrawDataSnapshot> m_snapshots;
+        std::atomic<uint64_t> m_renderedFrameIndex{0};
+        std::atomic<bool> m_renderThreadFailed{false}; // the GL thread could not take the context
+        uint64_t m_publishedFrameIndex = 0;
+        RenderThreadStats m_renderThreadStats;
+        FrameProfiler m_profiler;
+        ProgramBinaryCache m_programCache;
+
+        // The scheduler's swap interval, applied with eglSwapInterval() by the thread that presents.
+        std::atomic<int32_t> m_swapInterval{1};
+        int32_t m_appliedSwapInterval = 0; // 0 until set on the current surface
+
+        // Partial update, only touched by the thread that submits frames.
+        bool m_partialUpdate = false;
+        PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC m_swapBuffersWithDamage = nullptr;
+        DamageTracker m_damageTracker;
+        ImVector<ImVec4> m_savedClipRects;
+        ImVector<EGLint> m_damageRects;
+
+        SurfaceFitter m_surfaceFitter;
+        SurfaceFitter m_cropFitter;
+        ResolutionScaler m_resolutionScaler;
+        std::atomic<int64_t> m_frameCost{0};   // GPU time, else CPU draw time, of the last frame
+        ImVec2 m_framebufferScale{1.0f, 1.0f}; // buffer size / surface size
+        SurfaceLayout m_layout;                // what frames are built for, UI thread
+        SurfaceLayout m_appliedLayout;         // what the layer was given, presenting thread
 
         ANativeWindow *m_nativeWindow = nullptr;
+        bool m_followDisplaySize = false; // the window was sized from the display
+        float m_frameRateHint = 0.0f;     // last rate voted for on the layer
+        int32_t m_preRotation = 0;        // quarter turns clockwise the output is rendered with
         EGLDisplay m_display = EGL_NO_DISPLAY;
         EGLSurface m_surface = EGL_NO_SURFACE;
         EGLContext m_context = EGL_NO_CONTEXT;
+        EGLConfig m_config = nullptr;
         ImGuiContext *m_imguiContext = nullptr;
+
+        GLuint m_headlessFramebuffer = 0;  // surfaceless fallback render target
+        GLuint m_headlessColorBuffer = 0;
+        bool m_headlessSurfaceless = false;
+        int64_t m_lastFrameTime = 0;
     };
 
 } // namespace android
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+#include "DrawDataFingerprint.hpp"
+
+namespace android
+{
+    // Tracks which screen rectangles changed between submitted frames. Draw lists are
+    // compared by position in CmdLists, a list that changed (or moved in the z-order)
+    // damages both its old and its new bounds. Rectangles are in ImGui display
+    // coordinates, like ImDrawCmd::ClipRect (x1, y1, x2, y2).
+    class DamageTracker
+    {
+    public:
+        static constexpr int32_t kMaxRects = 4;    // per frame, more get merged into one
+        static constexpr int32_t kHistorySize = 4; // frames of damage kept for buffer age
+
+        // Call once per submitted (swapped) frame.
+        void Update(const ImDrawData *drawData)
+        {
+            m_damage.resize(0);
+
+            ImVec4 display(drawData->DisplayPos.x, drawData->DisplayPos.y,
+                           drawData->DisplayPos.x + drawData->DisplaySize.x, drawData->DisplayPos.y + drawData->DisplaySize.y);
+
+            bool full = m_invalidated || !SameRect(display, m_display) ||
+                        drawData->FramebufferScale.x != m_framebufferScale.x ||
+                        drawData->FramebufferScale.y != m_framebufferScale.y;
+            m_invalidated = false;
+            m_display = display;
+            m_framebufferScale = drawData->FramebufferScale;
+
+            // Texture content changes are not visible in the draw lists.
+            if (drawData->Textures)
+                for (const ImTextureData *tex : *drawData->Textures)
+                    if (tex->Status != ImTextureStatus_OK)
+                        full = true;
+
+            int32_t count = drawData->CmdLists.Size;
+            m_current.resize(count);
+            for (int32_t i = 0; i < count; ++i)
+            {
+                const ImDrawList *drawList = drawData->CmdLists[i];
+                ListState &state = m_current[i];
+                state.hash = HashList(drawList);
+                state.bounds = ComputeBounds(drawList, display);
+
+                for (const ImDrawCmd &cmd : drawList->CmdBuffer)
+                    if (cmd.UserCallback && cmd.UserCallback != ImDrawCallback_ResetRenderState)
+                        full = true;
+            }
+
+            if (full)
+            {
+                AddRect(display);
+            }
+            else
+            {
+                for (int32_t i = 0; i < count || i < m_previous.Size; ++i)
+                {
+                    bool hasOld = i < m_previous.Size, hasNew = i < count;
+                    if (hasOld && hasNew && m_previous[i].hash == m_current[i].hash && SameRect(m_previous[i].bounds, m_current[i].bounds))
+                        continue;
+                    if (hasOld)
+                        AddRect(m_previous[i].bounds);
+                    if (hasNew)
+                        AddRect(m_current[i].bounds);
+                }
+            }
+
+            m_previous.swap(m_current);
+
+            m_history[m_frameCount % kHistorySize] = GetBounds(m_damage);
+            ++m_frameCount;
+        }
+
+        // Damage of the last Update(), for eglSwapBuffersWithDamageKHR. Empty when nothing changed.
+        const ImVector<ImVec4> &GetDamage() const { return m_damage; }
+
+        // Area to repaint in a back buffer holding the frame from `bufferAge` swaps ago.
+        // Returns false when its content is unknown and the whole display must be redrawn.
+        bool GetRepaintRect(int32_t bufferAge, ImVec4 *outRect) const
+        {
+            if (bufferAge <= 0 || bufferAge > kHistorySize || static_cast<uint64_t>(bufferAge) >= m_frameCount)
+                return false;
+
+            ImVec4 rect(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (int32_t i = 1; i <= bufferAge; ++i)
+                rect = Union(rect, m_history[(m_frameCount - i) % kHistorySize]);
+            *outRect = rect;
+            return true;
+        }
+
+        // Forces full damage on the next Update(), e.g. after the surface was recreated.
+        void Invalidate() { m_invalidated = true; }
+
+        static bool IsEmpty(const ImVec4 &rect) { return rect.z <= rect.x || rect.w <= rect.y; }
+
+        // Vertex bounding box of a draw list, limited to what its clip rects and the display let through.
+        static ImVec4 ComputeBounds(const ImDrawList *drawList, const ImVec4 &display)
+        {
+            ImVec4 clip(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const ImDrawCmd &cmd : drawList->CmdBuffer)
+                if (cmd.ElemCount > 0)
+                    clip = Union(clip, cmd.ClipRect);
+
+            ImVec4 bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const ImDrawVert &vert : drawList->VtxBuffer)
+            {
+                bounds.x = std::min(bounds.x, vert.pos.x);
+                bounds.y = std::min(bounds.y, vert.pos.y);
+                bounds.z = std::max(bounds.z, vert.pos.x);
+                bounds.w = std::max(bounds.w, vert.pos.y);
+            }
+
+            return Intersect(Intersect(bounds, clip), display);
+        }
+
+        static ImVec4 Union(const ImVec4 &a, const ImVec4 &b)
+        {
+            if (IsEmpty(b))
+                return a;
+            if (IsEmpty(a))
+                return b;
+            return ImVec4(std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w));
+        }
+
+    private:
+        struct ListState
+        {
+            uint64_t hash = 0;
+            ImVec4 bounds;
+        };
+
+        static uint64_t HashList(const ImDrawList *drawList)
+        {
+            uint64_t hash = HashBytes(drawList->VtxBuffer.Data, drawList->VtxBuffer.size_in_bytes(), 0);
+            hash = HashBytes(drawList->IdxBuffer.Data, drawList->IdxBuffer.size_in_bytes(), hash);
+            return HashBytes(drawList->CmdBuffer.Data, drawList->CmdBuffer.size_in_bytes(), hash);
+        }
+
+        // Overlapping rectangles are merged, past kMaxRects everything collapses into one.
+        void AddRect(ImVec4 rect)
+        {
+            if (IsEmpty(rect))
+                return;
+
+            for (int32_t i = 0; i < m_damage.Size;)
+            {
+                if (Overlaps(m_damage[i], rect))
+                {
+                    rect = Union(rect, m_damage[i]);
+                    m_damage.erase_unsorted(m_damage.Data + i);
+                    i = 0;
+                    continue;
+                }
+                ++i;
+            }
+            m_damage.push_back(rect);
+
+            if (m_damage.Size > kMaxRects)
+            {
+                ImVec4 bounds = GetBounds(m_damage);
+                m_damage.resize(1);
+                m_damage[0] = bounds;
+            }
+        }
+
+        static ImVec4 GetBounds(const ImVector<ImVec4> &rects)
+        {
+            ImVec4 bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const ImVec4 &rect : rects)
+                bounds = Union(bounds, rect);
+            return bounds;
+        }
+
+        static ImVec4 Intersect(const ImVec4 &a, const ImVec4 &b)
+        {
+            return ImVec4(std::max(a.x, b.x), std::max(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w));
+        }
+
+        static bool Overlaps(const ImVec4 &a, const ImVec4 &b)
+        {
+            return a.x <= b.z && b.x <= a.z && a.y <= b.w && b.y <= a.w;
+        }
+
+        static bool SameRect(const ImVec4 &a, const ImVec4 &b)
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+        }
+
+    private:
+        ImVector<ListState> m_previous;
+        ImVector<ListState> m_current;
+        ImVector<ImVec4> m_damage;
+        ImVec4 m_history[kHistorySize];
+        uint64_t m_frameCount = 0;
+
+        ImVec4 m_display;
+        ImVec2 m_framebufferScale;
+        bool m_invalidated = false;
+    };
+
+} // namespace android
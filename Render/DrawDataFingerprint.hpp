@@ -0,0 +1,99 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace android
+{
+    // 64-bit MurmurHash2 (MurmurHash64A) over a byte range, 8 bytes per step.
+    inline uint64_t HashBytes(const void *data, size_t length, uint64_t seed)
+    {
+        constexpr uint64_t m = 0xc6a4a7935bd1e995ULL;
+        constexpr int r = 47;
+
+        uint64_t h = seed ^ (length * m);
+
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        const uint8_t *end = bytes + (length & ~static_cast<size_t>(7));
+
+        for (; bytes != end; bytes += 8)
+        {
+            uint64_t k;
+            memcpy(&k, bytes, sizeof(k));
+
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+
+            h ^= k;
+            h *= m;
+        }
+
+        if (size_t tail = length & 7)
+        {
+            uint64_t k = 0;
+            memcpy(&k, bytes, tail);
+            h ^= k;
+            h *= m;
+        }
+
+        h ^= h >> r;
+        h *= m;
+        h ^= h >> r;
+        return h;
+    }
+
+    // Fingerprints everything in an ImDrawData that affects the rendered pixels:
+    // display rect, vertex/index buffers and commands (clip rects, textures, offsets).
+    // ImDrawCmd zeroes its padding, so command buffers can be hashed as raw bytes.
+    class DrawDataFingerprint
+    {
+    public:
+        // Returns true when the draw data differs from the previous call.
+        bool Update(const ImDrawData *drawData)
+        {
+            bool forceChanged = m_invalidated;
+            m_invalidated = false;
+
+            uint64_t hash = HashBytes(&drawData->DisplayPos, sizeof(ImVec2), 0);
+            hash = HashBytes(&drawData->DisplaySize, sizeof(ImVec2), hash);
+            hash = HashBytes(&drawData->FramebufferScale, sizeof(ImVec2), hash);
+
+            for (const ImDrawList *drawList : drawData->CmdLists)
+            {
+                hash = HashBytes(drawList->VtxBuffer.Data, drawList->VtxBuffer.size_in_bytes(), hash);
+                hash = HashBytes(drawList->IdxBuffer.Data, drawList->IdxBuffer.size_in_bytes(), hash);
+                hash = HashBytes(drawList->CmdBuffer.Data, drawList->CmdBuffer.size_in_bytes(), hash);
+
+                // Callbacks may draw anything, never consider them unchanged.
+                for (const ImDrawCmd &cmd : drawList->CmdBuffer)
+                    if (cmd.UserCallback && cmd.UserCallback != ImDrawCallback_ResetRenderState)
+                        forceChanged = true;
+            }
+
+            // Pending texture work has to reach the renderer this frame.
+            if (drawData->Textures)
+                for (const ImTextureData *tex : *drawData->Textures)
+                    if (tex->Status != ImTextureStatus_OK)
+                        forceChanged = true;
+
+            bool changed = forceChanged || !m_valid || hash != m_hash;
+            m_hash = hash;
+            m_valid = true;
+            return changed;
+        }
+
+        // Makes the next Update() report a change, e.g. after the surface was recreated.
+        void Invalidate() { m_invalidated = true; }
+
+        uint64_t GetHash() const { return m_hash; }
+
+    private:
+        uint64_t m_hash = 0;
+        bool m_valid = false;
+        bool m_invalidated = false;
+    };
+
+} // namespace android
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace android
+{
+    // Layer position and size in display pixels, its buffer size, and the crop in buffer
+    // pixels (empty for none). A frame carries the layout it was built for, so a renderer
+    // on another thread changes the layer together with the buffer that matches it.
+    struct SurfaceLayout
+    {
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+        int32_t bufferWidth = 0;
+        int32_t bufferHeight = 0;
+        int32_t cropLeft = 0;
+        int32_t cropTop = 0;
+        int32_t cropRight = 0;
+        int32_t cropBottom = 0;
+
+        bool HasSameGeometry(const SurfaceLayout &other) const
+        {
+            return x == other.x && y == other.y && width == other.width && height == other.height &&
+                   bufferWidth == other.bufferWidth && bufferHeight == other.bufferHeight;
+        }
+
+        bool HasSameCrop(const SurfaceLayout &other) const
+        {
+            return cropLeft == other.cropLeft && cropTop == other.cropTop &&
+                   cropRight == other.cropRight && cropBottom == other.cropBottom;
+        }
+    };
+
+    // Owned copy of an ImDrawData, so a frame can be rendered on another thread
+    // while the UI thread already builds the next one. Draw lists and their buffers
+    // are reused between captures, steady state capture does not allocate.
+    class DrawDataSnapshot
+    {
+    public:
+        DrawDataSnapshot() = default;
+        DrawDataSnapshot(const DrawDataSnapshot &) = delete;
+        DrawDataSnapshot &operator=(const DrawDataSnapshot &) = delete;
+
+        ~DrawDataSnapshot()
+        {
+            for (ImDrawList *drawList : m_drawLists)
+                IM_DELETE(drawList);
+        }
+
+        void Capture(const ImDrawData *source, uint64_t frameIndex, int64_t timestamp)
+        {
+            m_frameIndex = frameIndex;
+            m_timestamp = timestamp;
+            m_hasTextureUpdates = false;
+
+            m_drawData.Clear();
+            m_drawData.Valid = source->Valid;
+            m_drawData.DisplayPos = source->DisplayPos;
+            m_drawData.DisplaySize = source->DisplaySize;
+            m_drawData.FramebufferScale = source->FramebufferScale;
+
+            // Texture updates are only forwarded when there is work to do. The owner must keep
+            // the UI thread away from these textures until the snapshot has been rendered.
+            if (source->Textures)
+                for (const ImTextureData *tex : *source->Textures)
+                    if (tex->Status != ImTextureStatus_OK)
+                        m_hasTextureUpdates = true;
+            m_drawData.Textures = m_hasTextureUpdates ? source->Textures : nullptr;
+
+            while (m_drawLists.Size < source->CmdLists.Size)
+                m_drawLists.push_back(IM_NEW(ImDrawList)(nullptr));
+
+            // Filled directly rather than through ImDrawData::AddDrawList(), which validates
+            // the write cursors of a list that is still being built.
+            for (int i = 0; i < source->CmdLists.Size; ++i)
+            {
+                const ImDrawList *src = source->CmdLists[i];
+                ImDrawList *dst = m_drawLists[i];
+
+                CopyVector(dst->CmdBuffer, src->CmdBuffer);
+                CopyVector(dst->IdxBuffer, src->IdxBuffer);
+                CopyVector(dst->VtxBuffer, src->VtxBuffer);
+                CopyVector(dst->_CallbacksDataBuf, src->_CallbacksDataBuf);
+                dst->Flags = src->Flags;
+
+                // Callback payloads stored inside the list must point at our copy.
+                for (ImDrawCmd &cmd : dst->CmdBuffer)
+                    if (cmd.UserCallback && cmd.UserCallbackDataSize > 0 && cmd.UserCallbackDataOffset >= 0)
+                        cmd.UserCallbackData = dst->_CallbacksDataBuf.Data + cmd.UserCallbackDataOffset;
+
+                m_drawData.CmdLists.push_back(dst);
+                m_drawData.TotalVtxCount += dst->VtxBuffer.Size;
+                m_drawData.TotalIdxCount += dst->IdxBuffer.Size;
+            }
+            m_drawData.CmdListsCount = m_drawData.CmdLists.Size;
+        }
+
+        void SetLayout(const SurfaceLayout &layout) { m_layout = layout; }
+
+        ImDrawData *Get() { return &m_drawData; }
+        const SurfaceLayout &GetLayout() const { return m_layout; }
+        uint64_t GetFrameIndex() const { return m_frameIndex; }
+        int64_t GetTimestamp() const { return m_timestamp; }
+        bool HasTextureUpdates() const { return m_hasTextureUpdates; }
+
+    private:
+        template <typename T>
+        static void CopyVector(ImVector<T> &dst, const ImVector<T> &src)
+        {
+            dst.resize(src.Size);
+            if (src.Size > 0)
+                memcpy(dst.Data, src.Data, static_cast<size_t>(src.size_in_bytes()));
+        }
+
+    private:
+        ImDrawData m_drawData;
+        ImVector<ImDrawList *> m_drawLists;
+        SurfaceLayout m_layout;
+        uint64_t m_frameIndex = 0;
+        int64_t m_timestamp = 0;
+        bool m_hasTextureUpdates = false;
+    };
+
+} // namespace android
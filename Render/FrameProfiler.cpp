@@ -0,0 +1,236 @@
+#include "FrameProfiler.hpp"
+
+#include <imgui.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace android
+{
+    namespace
+    {
+        PFNGLGENQUERIESEXTPROC glGenQueriesEXT_ = nullptr;
+        PFNGLDELETEQUERIESEXTPROC glDeleteQueriesEXT_ = nullptr;
+        PFNGLBEGINQUERYEXTPROC glBeginQueryEXT_ = nullptr;
+        PFNGLENDQUERYEXTPROC glEndQueryEXT_ = nullptr;
+        PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivEXT_ = nullptr;
+        PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT_ = nullptr;
+
+        bool HasGLExtension(const char *name)
+        {
+            const char *extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+            if (!extensions)
+                return false;
+
+            const size_t length = strlen(name);
+            for (const char *p = strstr(extensions, name); p; p = strstr(p + length, name))
+                if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+                    return true;
+            return false;
+        }
+    } // namespace
+
+    void FrameProfiler::Record(Phase phase, int64_t wall, int64_t cpu)
+    {
+        History &history = m_history[phase];
+        uint32_t count = history.count.load(std::memory_order_relaxed);
+        uint32_t slot = count % kHistorySize;
+        history.wall[slot].store(wall, std::memory_order_relaxed);
+        history.cpu[slot].store(cpu, std::memory_order_relaxed);
+        history.count.store(count + 1, std::memory_order_release);
+    }
+
+    int32_t FrameProfiler::GetSamples(Phase phase, float *outMs, bool cpu) const
+    {
+        const History &history = m_history[phase];
+        uint32_t count = history.count.load(std::memory_order_acquire);
+        int32_t size = static_cast<int32_t>(std::min<uint32_t>(count, kHistorySize));
+
+        const std::atomic<int64_t> *samples = cpu ? history.cpu : history.wall;
+        for (int32_t i = 0; i < size; ++i)
+        {
+            uint32_t slot = (count - size + i) % kHistorySize;
+            outMs[i] = static_cast<float>(samples[slot].load(std::memory_order_relaxed)) * 1e-6f;
+        }
+        return size;
+    }
+
+    int64_t FrameProfiler::GetLatest(Phase phase) const
+    {
+        const History &history = m_history[phase];
+        uint32_t count = history.count.load(std::memory_order_acquire);
+        return count ? history.wall[(count - 1) % kHistorySize].load(std::memory_order_relaxed) : 0;
+    }
+
+    FrameProfiler::Percentiles FrameProfiler::GetPercentiles(Phase phase, bool cpu) const
+    {
+        Percentiles result;
+
+        float samples[kHistorySize];
+        int32_t size = GetSamples(phase, samples, cpu);
+        if (0 == size)
+            return result;
+
+        auto at = [&](float percentile)
+        {
+            int32_t index = std::min(size - 1, static_cast<int32_t>(percentile * size));
+            std::nth_element(samples, samples + index, samples + size);
+            return samples[index];
+        };
+
+        result.p50 = at(0.50f);
+        result.p95 = at(0.95f);
+        result.p99 = at(0.99f);
+        return result;
+    }
+
+    bool FrameProfiler::InitGpuTimer()
+    {
+        m_gpuTimer = false;
+        m_gpuIssued = m_gpuCollected = 0;
+
+        if (!HasGLExtension("GL_EXT_disjoint_timer_query"))
+            return false;
+
+        glGenQueriesEXT_ = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(eglGetProcAddress("glGenQueriesEXT"));
+        glDeleteQueriesEXT_ = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(eglGetProcAddress("glDeleteQueriesEXT"));
+        glBeginQueryEXT_ = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(eglGetProcAddress("glBeginQueryEXT"));
+        glEndQueryEXT_ = reinterpret_cast<PFNGLENDQUERYEXTPROC>(eglGetProcAddress("glEndQueryEXT"));
+        glGetQueryObjectuivEXT_ = reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(eglGetProcAddress("glGetQueryObjectuivEXT"));
+        glGetQueryObjectui64vEXT_ = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(eglGetProcAddress("glGetQueryObjectui64vEXT"));
+
+        if (!glGenQueriesEXT_ || !glDeleteQueriesEXT_ || !glBeginQueryEXT_ || !glEndQueryEXT_ ||
+            !glGetQueryObjectuivEXT_ || !glGetQueryObjectui64vEXT_)
+            return false;
+
+        glGenQueriesEXT_(kGpuQueryCount, m_gpuQueries);
+        return (m_gpuTimer = true);
+    }
+
+    void FrameProfiler::ShutdownGpuTimer()
+    {
+        if (!m_gpuTimer)
+            return;
+
+        glDeleteQueriesEXT_(kGpuQueryCount, m_gpuQueries);
+        memset(m_gpuQueries, 0, sizeof(m_gpuQueries));
+        m_gpuTimer = false;
+    }
+
+    void FrameProfiler::BeginGpu()
+    {
+        if (!m_gpuTimer)
+            return;
+
+        CollectGpu();
+
+        // All queries still in flight, skip this frame rather than stall on a result.
+        if (m_gpuIssued - m_gpuCollected >= kGpuQueryCount)
+            return;
+
+        glBeginQueryEXT_(GL_TIME_ELAPSED_EXT, m_gpuQueries[m_gpuIssued % kGpuQueryCount]);
+        ++m_gpuIssued;
+        m_gpuActive = true;
+    }
+
+    void FrameProfiler::EndGpu()
+    {
+        if (!m_gpuActive)
+            return;
+
+        glEndQueryEXT_(GL_TIME_ELAPSED_EXT);
+        m_gpuActive = false;
+    }
+
+    void FrameProfiler::CollectGpu()
+    {
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+        while (m_gpuCollected != m_gpuIssued)
+        {
+            GLuint query = m_gpuQueries[m_gpuCollected % kGpuQueryCount];
+
+            GLuint available = 0;
+            glGetQueryObjectuivEXT_(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+            if (!available)
+                break;
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64vEXT_(query, GL_QUERY_RESULT_EXT, &elapsed);
+            ++m_gpuCollected;
+
+            // A disjoint event (frequency change, context switch) invalidates pending results.
+            // Some drivers report garbage for their very first query (llvmpipe: hours).
+            if (!disjoint && elapsed < 1000000000ULL)
+                Record(PhaseGpu, static_cast<int64_t>(elapsed), 0);
+        }
+    }
+
+    const char *FrameProfiler::GetPhaseName(Phase phase)
+    {
+        switch (phase)
+        {
+        case PhaseNewFrame:
+            return "NewFrame";
+        case PhaseBuild:
+            return "Build UI";
+        case PhaseRender:
+            return "Render";
+        case PhaseDraw:
+            return "Draw";
+        case PhaseSwap:
+            return "Swap";
+        case PhaseGpu:
+            return "GPU";
+        default:
+            return "?";
+        }
+    }
+
+    void FrameProfiler::ShowWindow(bool *open)
+    {
+        if (!ImGui::Begin("Frame Profiler", open, ImGuiWindowFlags_AlwaysAutoResize))
+        {
+            ImGui::End();
+            return;
+        }
+
+        if (!m_enabled)
+        {
+            ImGui::TextUnformatted("Profiler disabled");
+            ImGui::End();
+            return;
+        }
+
+        float samples[kHistorySize];
+        for (int32_t i = 0; i < PhaseCount; ++i)
+        {
+            auto phase = static_cast<Phase>(i);
+            if (phase == PhaseGpu && !m_gpuTimer)
+                continue;
+
+            int32_t size = GetSamples(phase, samples);
+            if (0 == size)
+                continue;
+
+            Percentiles wall = GetPercentiles(phase);
+            ImGui::Text("%-8s p50 %6.3f  p95 %6.3f  p99 %6.3f ms", GetPhaseName(phase), wall.p50, wall.p95, wall.p99);
+            if (phase != PhaseGpu)
+            {
+                Percentiles cpu = GetPercentiles(phase, true);
+                ImGui::Text("%-8s p50 %6.3f  p95 %6.3f  p99 %6.3f ms", "  cpu", cpu.p50, cpu.p95, cpu.p99);
+            }
+
+            ImGui::PushID(i);
+            ImGui::PlotLines("##wall", samples, size, 0, nullptr, 0.0f, wall.p99 > 0.0f ? wall.p99 * 1.25f : FLT_MAX, ImVec2(0.0f, 40.0f));
+            ImGui::PopID();
+        }
+
+        ImGui::End();
+    }
+
+} // namespace android
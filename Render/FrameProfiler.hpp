@@ -0,0 +1,123 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace android
+{
+    // Per-phase frame timing. Each phase keeps wall and thread CPU time of the last
+    // kHistorySize frames in a fixed ring. A phase is always written by the thread that
+    // runs it, readers (the HUD, GetSamples) may live on any thread.
+    class FrameProfiler
+    {
+    public:
+        enum Phase : int32_t
+        {
+            PhaseNewFrame = 0, // backend + ImGui::NewFrame
+            PhaseBuild,        // user UI between BeginFrame and EndFrame
+            PhaseRender,       // ImGui::Render
+            PhaseDraw,         // texture/buffer upload and draw calls
+            PhaseSwap,         // eglSwapBuffers
+            PhaseGpu,          // EXT_disjoint_timer_query, wall time only
+            PhaseCount
+        };
+
+        static constexpr int32_t kHistorySize = 256;
+
+        struct Percentiles
+        {
+            float p50 = 0.0f;
+            float p95 = 0.0f;
+            float p99 = 0.0f;
+        };
+
+    public:
+        FrameProfiler() = default;
+        FrameProfiler(const FrameProfiler &) = delete;
+        FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+        void SetEnabled(bool enabled) { m_enabled = enabled; }
+        bool IsEnabled() const { return m_enabled; }
+
+        inline void Begin(Phase phase)
+        {
+            if (!m_enabled)
+                return;
+
+            m_begin[phase].wall = ReadClock(CLOCK_MONOTONIC);
+            m_begin[phase].cpu = ReadClock(CLOCK_THREAD_CPUTIME_ID);
+        }
+
+        inline void End(Phase phase)
+        {
+            if (!m_enabled)
+                return;
+
+            int64_t wall = ReadClock(CLOCK_MONOTONIC) - m_begin[phase].wall;
+            int64_t cpu = ReadClock(CLOCK_THREAD_CPUTIME_ID) - m_begin[phase].cpu;
+            Record(phase, wall, cpu);
+        }
+
+        void Record(Phase phase, int64_t wall, int64_t cpu);
+
+        // Copies up to kHistorySize samples in milliseconds, oldest first. Returns the count.
+        int32_t GetSamples(Phase phase, float *outMs, bool cpu = false) const;
+        Percentiles GetPercentiles(Phase phase, bool cpu = false) const;
+        // Wall time of the latest sample in ns, 0 before the first one.
+        int64_t GetLatest(Phase phase) const;
+
+        // GPU time through EXT_disjoint_timer_query. All calls need the GL context current,
+        // Begin/EndGpu wrap the draw phase and are no-ops when the extension is missing.
+        // Once initialized the timer runs even with the profiler disabled.
+        bool InitGpuTimer();
+        void ShutdownGpuTimer();
+        void BeginGpu();
+        void EndGpu();
+        bool HasGpuTimer() const { return m_gpuTimer; }
+
+        // Graphs and p50/p95/p99 of every phase in an ImGui window.
+        void ShowWindow(bool *open = nullptr);
+
+        static const char *GetPhaseName(Phase phase);
+
+    private:
+        static inline int64_t ReadClock(clockid_t clock)
+        {
+            timespec ts{};
+            clock_gettime(clock, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+        }
+
+        void CollectGpu();
+
+    private:
+        struct Stamp
+        {
+            int64_t wall = 0;
+            int64_t cpu = 0;
+        };
+
+        struct History
+        {
+            std::atomic<int64_t> wall[kHistorySize]{};
+            std::atomic<int64_t> cpu[kHistorySize]{};
+            std::atomic<uint32_t> count{0};
+        };
+
+        static constexpr int32_t kGpuQueryCount = 4;
+
+        bool m_enabled = false;
+        Stamp m_begin[PhaseCount];
+        History m_history[PhaseCount];
+
+        bool m_gpuTimer = false;
+        GLuint m_gpuQueries[kGpuQueryCount]{};
+        uint32_t m_gpuIssued = 0;    // queries begun
+        uint32_t m_gpuCollected = 0; // queries read back
+        bool m_gpuActive = false;
+    };
+
+} // namespace android
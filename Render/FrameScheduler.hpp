@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstdint>
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+
+namespace android
+{
+    // Monotonic time source used by FrameScheduler. Times are in nanoseconds.
+    // Replace it to drive the scheduler from a fake clock on a host build.
+    class FrameClock
+    {
+    public:
+        virtual ~FrameClock() = default;
+
+        virtual int64_t Now() = 0;
+        virtual void SleepUntil(int64_t deadline) = 0;
+    };
+
+    class SteadyFrameClock : public FrameClock
+    {
+    public:
+        int64_t Now() override
+        {
+            timespec ts{};
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+        }
+
+        void SleepUntil(int64_t deadline) override
+        {
+            timespec ts{};
+            ts.tv_sec = static_cast<time_t>(deadline / 1000000000LL);
+            ts.tv_nsec = static_cast<long>(deadline % 1000000000LL);
+            while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr))
+                ;
+        }
+
+        static SteadyFrameClock &Instance()
+        {
+            static SteadyFrameClock clock;
+            return clock;
+        }
+    };
+
+    // Paces frames on a fixed grid derived from the display refresh period.
+    // The target rate is snapped to an integer divisor of the refresh rate so every
+    // frame lands on the same number of vsync intervals. A frame that overruns its
+    // deadline is not followed by a burst of catch-up frames: the grid is re-phased
+    // to the next slot after the current time and the missed slots are counted.
+    // With an idle rate set, the scheduler drops to it when no activity was reported for a
+    // while and returns to the target rate on the next NotifyActivity(), re-phasing the
+    // grid from the current frame either way.
+    // When the swap itself waits for vsync at GetSwapInterval() (see SetSwapPaced()), the
+    // scheduler only sleeps off what the frame left of its period and phase-locks to the swap.
+    class FrameScheduler
+    {
+    public:
+        struct Stats
+        {
+            uint64_t frames = 0;
+            uint64_t missedDeadlines = 0;
+            uint64_t droppedIntervals = 0;
+            int64_t lastFrameTime = 0;
+            int64_t maxFrameTime = 0;
+            uint64_t idleFrames = 0;
+            uint64_t swapWaits = 0;
+        };
+
+    public:
+        explicit FrameScheduler(FrameClock *clock = nullptr)
+            : m_clock(clock ? clock : &SteadyFrameClock::Instance())
+        {
+            UpdatePeriod();
+        }
+
+        void SetDisplayRefreshRate(float refreshRate)
+        {
+            m_refreshRate = refreshRate > 1.0f ? refreshRate : 60.0f;
+            UpdatePeriod();
+        }
+
+        // 0 follows the display refresh rate.
+        void SetTargetFrameRate(float frameRate)
+        {
+            m_targetFrameRate = frameRate > 0.0f ? frameRate : 0.0f;
+            UpdatePeriod();
+        }
+
+        // 0 disables idling. idleTimeout is in ns.
+        void SetIdleFrameRate(float frameRate, int64_t idleTimeout)
+        {
+            m_idleFrameRate = frameRate > 0.0f ? frameRate : 0.0f;
+            m_idleTimeout = idleTimeout > 0 ? idleTimeout : 0;
+            if (0.0f == m_idleFrameRate)
+                SetIdle(false);
+            UpdatePeriod();
+        }
+
+        // The caller applies GetSwapInterval() with eglSwapInterval() and presents on this
+        // thread, so a swap running ahead of the display blocks until vsync. A frame that comes
+        // back late by less than a period was held by the swap: the grid follows it instead of
+        // skipping to the next slot. The grid runs slightly faster than the nominal period, so
+        // the display stays the slower clock and a refresh rate that is reported a little off
+        // can't leave a frame on screen for an extra interval.
+        void SetSwapPaced(bool swapPaced)
+        {
+            m_swapPaced = swapPaced;
+        }
+
+        // Input, animation or anything else that wants the full rate. Cheap, call every frame it applies.
+        void NotifyActivity()
+        {
+            m_lastActivity = m_clock->Now();
+            SetIdle(false);
+        }
+
+        // The rate the content is meant to change at: the idle rate while idle, else the
+        // target rate, 0 when following the display.
+        float GetContentFrameRate() const { return m_idle ? m_idleFrameRate : m_targetFrameRate; }
+
+        bool IsIdle() const { return m_idle; }
+        bool IsSwapPaced() const { return m_swapPaced; }
+        float GetDisplayRefreshRate() const { return m_refreshRate; }
+        float GetFrameRate() const { return 1e9f / static_cast<float>(m_framePeriod); }
+        int64_t GetFramePeriod() const { return m_framePeriod; }
+        int32_t GetSwapInterval() const { return m_interval; }
+        const Stats &GetStats() const { return m_stats; }
+
+        void Reset()
+        {
+            m_nextDeadline = 0;
+            m_frameStart = 0;
+            m_lastActivity = 0;
+            m_stats = {};
+            SetIdle(false);
+        }
+
+        // Blocks until the start of the next frame slot. Call once per frame after presenting.
+        void WaitForNextFrame()
+        {
+            int64_t now = m_clock->Now();
+
+            if (0 == m_nextDeadline)
+            {
+                m_nextDeadline = now + m_framePeriod;
+                m_frameStart = now;
+                m_lastActivity = now;
+            }
+
+            if (m_idleFrameRate > 0.0f && !m_idle && now - m_lastActivity >= m_idleTimeout)
+                SetIdle(true);
+            if (m_idle)
+                ++m_stats.idleFrames;
+
+            int64_t frameTime = now - m_frameStart;
+            m_stats.lastFrameTime = frameTime;
+            if (frameTime > m_stats.maxFrameTime)
+                m_stats.maxFrameTime = frameTime;
+            ++m_stats.frames;
+
+            if (now > m_nextDeadline && m_swapPaced)
+            {
+                // Whatever held the frame, the swap already lined it up with vsync.
+                int64_t late = (now - m_nextDeadline) / m_framePeriod;
+                if (late > 0)
+                {
+                    ++m_stats.missedDeadlines;
+                    m_stats.droppedIntervals += static_cast<uint64_t>(late);
+                }
+                else
+                {
+                    ++m_stats.swapWaits;
+                }
+                m_nextDeadline = now;
+            }
+            else if (now > m_nextDeadline)
+            {
+                int64_t late = (now - m_nextDeadline) / m_framePeriod + 1;
+                ++m_stats.missedDeadlines;
+                m_stats.droppedIntervals += static_cast<uint64_t>(late);
+                m_nextDeadline += late * m_framePeriod;
+            }
+
+            m_clock->SleepUntil(m_nextDeadline);
+
+            m_frameStart = m_nextDeadline;
+            m_nextDeadline += m_swapPaced ? m_framePeriod - m_framePeriod / kSwapPacedLead : m_framePeriod;
+        }
+
+    private:
+        // Swap paced, the grid gains one frame every kSwapPacedLead frames on the nominal period.
+        static constexpr int64_t kSwapPacedLead = 64;
+
+        void SetIdle(bool idle)
+        {
+            if (idle == m_idle)
+                return;
+
+            m_idle = idle;
+            UpdatePeriod();
+
+            // The slot after the current frame moves with the new period.
+            if (0 != m_nextDeadline)
+                m_nextDeadline = m_frameStart + m_framePeriod;
+        }
+
+        void UpdatePeriod()
+        {
+            const double refreshPeriod = 1e9 / static_cast<double>(m_refreshRate);
+            const float frameRate = GetContentFrameRate();
+
+            m_interval = 1;
+            if (frameRate > 0.0f && frameRate < m_refreshRate)
+                m_interval = static_cast<int32_t>(std::lround(m_refreshRate / frameRate));
+
+            m_framePeriod = static_cast<int64_t>(refreshPeriod * m_interval);
+        }
+
+    private:
+        FrameClock *m_clock;
+        float m_refreshRate = 60.0f;
+        float m_targetFrameRate = 0.0f;
+        float m_idleFrameRate = 0.0f;
+        int64_t m_idleTimeout = 0;
+        int64_t m_lastActivity = 0;
+        bool m_idle = false;
+        bool m_swapPaced = false;
+        int32_t m_interval = 1;
+        int64_t m_framePeriod = 16666667;
+        int64_t m_nextDeadline = 0;
+        int64_t m_frameStart = 0;
+        Stats m_stats;
+    };
+
+} // namespace android
@@ -23,6 +23,12 @@
 
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
+//  (AImGui): GL ES 3: stage texture creations and updates of a frame in a ring of pixel unpack buffers.
+//  (AImGui): Skip redundant glScissor()/glBindTexture(), merge draw calls with an owned context. Added ImGui_ImplOpenGL3_GetRenderStats().
+//  (AImGui): Owned GL ES 3 context: stream all draw lists through one fenced ring buffer. Added ImGui_ImplOpenGL3_GetStreamStats().
+//  (AImGui): Added ImGui_ImplOpenGL3_SetOwnedContext(), ImGui_ImplOpenGL3_InvalidateRenderState(): render without state backup/restore, large meshes on GL ES 3.2.
+//  (AImGui): Added ImGui_ImplOpenGL3_SetProgramCache() to link the shader program from a cached binary.
+//  (AImGui): Added ImGui_ImplOpenGL3_SetFramebufferRotation(), ImGui_ImplOpenGL3_RotateRect() for pre-rotated output.
 //  2025-09-18: Call platform_io.ClearRendererHandlers() on shutdown.
 //  2025-07-22: OpenGL: Add and call embedded loader shutdown during ImGui_ImplOpenGL3_Shutdown() to facilitate multiple init/shutdown cycles in same process. (#8792)
 //  2025-07-15: OpenGL: Set GL_UNPACK_ALIGNMENT to 1 before updating textures (#8802) + restore non-WebGL/ES update path that doesn't require a CPU-side copy.
@@ -213,6 +219,17 @@
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
 #endif
 
+// GL ES 3.2 has glDrawElementsBaseVertex(), earlier versions may have it as an extension. Resolved at runtime, see ImGui_ImplOpenGL3_SetOwnedContext().
+#if defined(IMGUI_IMPL_OPENGL_ES3)
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_BASE_VERTEX_PROC
+typedef void (GL_APIENTRY* ImGui_ImplOpenGL3_DrawElementsBaseVertexProc)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex);
+#endif
+
+// GL ES 3.0 has glMapBufferRange() and fence syncs for the owned-context stream buffer, and pixel unpack buffers for texture uploads. (The stripped desktop loader has neither.)
+#if defined(IMGUI_IMPL_OPENGL_ES3)
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+#endif
+
 // Desktop GL 3.3+ and GL ES 3.0+ have glBindSampler()
 #if !defined(IMGUI_IMPL_OPENGL_ES2) && (defined(IMGUI_IMPL_OPENGL_ES3) || defined(GL_VERSION_3_3))
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
@@ -227,6 +244,25 @@
 #define GL_CALL(_CALL)      _CALL   // Call without error check
 #endif
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+// Part of the stream buffer the GPU may still read
+struct ImGui_ImplOpenGL3_StreamSegment
+{
+    GLsync          Fence;
+    GLsizeiptr      Begin, End;
+};
+#endif
+
+// Owned context: one draw of consecutive commands sharing texture and scissor, or a user callback
+struct ImGui_ImplOpenGL3_Batch
+{
+    const ImDrawList* CallbackList;          // Callback batch when CallbackCmd is set
+    const ImDrawCmd*  CallbackCmd;
+    GLuint          Texture;
+    int             Scissor[4];
+    unsigned int    IdxOffset, ElemCount, VtxOffset;
+};
+
 // OpenGL Data
 struct ImGui_ImplOpenGL3_Data
 {
@@ -250,11 +286,48 @@ struct ImGui_ImplOpenGL3_Data
     bool            HasBindSampler;
     bool            HasClipOrigin;
     bool            UseBufferSubData;
+    int             FramebufferRotation;     // Quarter turns clockwise, see ImGui_ImplOpenGL3_SetFramebufferRotation()
+    ImGui_ImplOpenGL3_ProgramCache ProgramCache; // See ImGui_ImplOpenGL3_SetProgramCache()
     ImVector<char>  TempBuffer;
 
+    // Owned context, see ImGui_ImplOpenGL3_SetOwnedContext()
+    bool            OwnedContext;
+    bool            OwnedStateValid;         // Pipeline state is set and still in place
+    bool            HasBaseVertex;
+    GLuint          OwnedVertexArray;
+    GLsizeiptr      OwnedVtxAttribOffset;    // Byte offset the vertex attributes point at
+    GLuint          OwnedTexture;            // Bound to unit 0 in this frame, 0 when unknown
+    GLint           OwnedViewport[2];
+    GLint           OwnedScissor[4];
+    float           OwnedProjection[4][4];
+    ImVector<ImDrawVert> OwnedVtxBuffer;     // All draw lists of a frame, uploaded at once
+    ImVector<ImDrawIdx>  OwnedIdxBuffer;
+    ImVector<ImGui_ImplOpenGL3_Batch> OwnedBatches;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BASE_VERTEX_PROC
+    ImGui_ImplOpenGL3_DrawElementsBaseVertexProc DrawElementsBaseVertex;
+#endif
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    bool            UseStreamBuffer;         // Owned context: vertices and indices of every frame go through VboHandle, see ImGui_ImplOpenGL3_StreamAllocate()
+    bool            StreamGrow;              // A frame waited for the GPU, make room for more frames in flight
+    GLsizeiptr      StreamHead;
+    ImGui_ImplOpenGL3_StreamSegment StreamSegments[8]; // Frames in flight, oldest first
+    int             StreamSegmentCount;
+    GLuint          UploadBuffers[3];        // Pixel unpack buffers used in turn, one per frame with texture uploads, see ImGui_ImplOpenGL3_StageTextureUploads()
+    GLsizeiptr      UploadBufferSizes[3];
+    int             UploadBufferIndex;
+#endif
+    ImGui_ImplOpenGL3_StreamStats StreamStats;
+    ImGui_ImplOpenGL3_RenderStats RenderStats;
+
     ImGui_ImplOpenGL3_Data() { memset((void*)this, 0, sizeof(*this)); }
 };
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+static void ImGui_ImplOpenGL3_StreamRelease(ImGui_ImplOpenGL3_Data* bd);
+static void ImGui_ImplOpenGL3_StageTextureUploads(ImGui_ImplOpenGL3_Data* bd, ImVector<ImTextureData*>& textures);
+static void ImGui_ImplOpenGL3_UploadRelease(ImGui_ImplOpenGL3_Data* bd);
+#endif
+
 // Backend data stored in io.BackendRendererUserData to allow support for multiple Dear ImGui contexts
 // It is STRONGLY preferred that you use docking branch with multi-viewports (== single Dear ImGui context + multiple windows) instead of multiple Dear ImGui contexts.
 static ImGui_ImplOpenGL3_Data* ImGui_ImplOpenGL3_GetBackendData()
@@ -449,6 +522,151 @@ void    ImGui_ImplOpenGL3_NewFrame()
             IM_ASSERT(0 && "ImGui_ImplOpenGL3_CreateDeviceObjects() failed!");
 }
 
+void    ImGui_ImplOpenGL3_SetFramebufferRotation(int quarter_turns)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    bd->FramebufferRotation = quarter_turns & 3;
+}
+
+void    ImGui_ImplOpenGL3_SetProgramCache(const ImGui_ImplOpenGL3_ProgramCache* cache)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    bd->ProgramCache = cache ? *cache : ImGui_ImplOpenGL3_ProgramCache();
+}
+
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BASE_VERTEX_PROC
+static bool ImGui_ImplOpenGL3_HasExtension(const char* name)
+{
+    GLint num_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    for (GLint i = 0; i < num_extensions; i++)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension != nullptr && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+#endif
+
+void    ImGui_ImplOpenGL3_SetOwnedContext(bool owned, ImGui_ImplOpenGL3_GetProcAddress get_proc_address)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    ImGuiIO& io = ImGui::GetIO();
+
+    bd->OwnedContext = owned;
+    bd->OwnedStateValid = false;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    ImGui_ImplOpenGL3_StreamRelease(bd);
+    bd->UseStreamBuffer = owned;
+    bd->StreamStats = ImGui_ImplOpenGL3_StreamStats();
+#endif
+#ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
+    if (!owned && bd->OwnedVertexArray)
+    {
+        glDeleteVertexArrays(1, &bd->OwnedVertexArray);
+        bd->OwnedVertexArray = 0;
+    }
+#endif
+
+    // Base vertex: core in desktop GL 3.2 and GL ES 3.2, OES/EXT extension before that. Only the owned path uses it on GL ES.
+    bd->HasBaseVertex = false;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
+    bd->HasBaseVertex = (bd->GlVersion >= 320);
+#endif
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BASE_VERTEX_PROC
+    bd->DrawElementsBaseVertex = nullptr;
+    if (owned && get_proc_address != nullptr)
+    {
+        if (bd->GlVersion >= 320)
+            bd->DrawElementsBaseVertex = (ImGui_ImplOpenGL3_DrawElementsBaseVertexProc)get_proc_address("glDrawElementsBaseVertex");
+        if (bd->DrawElementsBaseVertex == nullptr && ImGui_ImplOpenGL3_HasExtension("GL_OES_draw_elements_base_vertex"))
+            bd->DrawElementsBaseVertex = (ImGui_ImplOpenGL3_DrawElementsBaseVertexProc)get_proc_address("glDrawElementsBaseVertexOES");
+        if (bd->DrawElementsBaseVertex == nullptr && ImGui_ImplOpenGL3_HasExtension("GL_EXT_draw_elements_base_vertex"))
+            bd->DrawElementsBaseVertex = (ImGui_ImplOpenGL3_DrawElementsBaseVertexProc)get_proc_address("glDrawElementsBaseVertexEXT");
+    }
+    bd->HasBaseVertex |= (bd->DrawElementsBaseVertex != nullptr);
+#endif
+    IM_UNUSED(get_proc_address);
+
+    if (bd->HasBaseVertex)
+        io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    else
+        io.BackendFlags &= ~ImGuiBackendFlags_RendererHasVtxOffset;
+}
+
+void    ImGui_ImplOpenGL3_InvalidateRenderState()
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+    bd->OwnedStateValid = false;
+}
+
+bool    ImGui_ImplOpenGL3_HasBaseVertex()
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    return bd != nullptr && bd->HasBaseVertex;
+}
+
+void    ImGui_ImplOpenGL3_GetRenderStats(ImGui_ImplOpenGL3_RenderStats* out_stats)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    *out_stats = bd ? bd->RenderStats : ImGui_ImplOpenGL3_RenderStats();
+}
+
+bool    ImGui_ImplOpenGL3_GetStreamStats(ImGui_ImplOpenGL3_StreamStats* out_stats)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    *out_stats = bd ? bd->StreamStats : ImGui_ImplOpenGL3_StreamStats();
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    return bd != nullptr && bd->UseStreamBuffer;
+#else
+    return false;
+#endif
+}
+
+// Moves a framebuffer rectangle (x, y, w, h, bottom-left origin) of the unrotated fb_width x fb_height output to where it lands after rotation.
+void    ImGui_ImplOpenGL3_RotateRect(int rotation, int fb_width, int fb_height, int* x, int* y, int* w, int* h)
+{
+    int rx = *x, ry = *y, rw = *w, rh = *h;
+    switch (rotation)
+    {
+    case 1: *x = ry;                   *y = fb_width - (rx + rw);  *w = rh; *h = rw; break;
+    case 2: *x = fb_width - (rx + rw); *y = fb_height - (ry + rh); break;
+    case 3: *x = fb_height - (ry + rh); *y = rx;                  *w = rh; *h = rw; break;
+    default: break;
+    }
+}
+
+// Our visible imgui space lies from draw_data->DisplayPos (top left) to draw_data->DisplayPos+data_data->DisplaySize (bottom right). DisplayPos is (0,0) for single viewport apps.
+static void ImGui_ImplOpenGL3_GetProjection(ImDrawData* draw_data, int rotation, bool clip_origin_lower_left, float ortho_projection[4][4])
+{
+    float L = draw_data->DisplayPos.x;
+    float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
+    float T = draw_data->DisplayPos.y;
+    float B = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+    if (!clip_origin_lower_left) { float tmp = T; T = B; B = tmp; } // Swap top and bottom if origin is upper left
+    const float projection[4][4] =
+    {
+        { 2.0f/(R-L),   0.0f,         0.0f,   0.0f },
+        { 0.0f,         2.0f/(T-B),   0.0f,   0.0f },
+        { 0.0f,         0.0f,        -1.0f,   0.0f },
+        { (R+L)/(L-R),  (T+B)/(B-T),  0.0f,   1.0f },
+    };
+    memcpy(ortho_projection, projection, sizeof(projection));
+    // Pre-rotation: turn clip space clockwise, (x, y) -> (y, -x) per quarter turn.
+    for (int turn = 0; turn < rotation; turn++)
+        for (int column = 0; column < 4; column++)
+        {
+            float x = ortho_projection[column][0];
+            ortho_projection[column][0] = ortho_projection[column][1];
+            ortho_projection[column][1] = -x;
+        }
+}
+
 static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_width, int fb_height, GLuint vertex_array_object)
 {
     ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
@@ -482,22 +700,15 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
 #endif
 
     // Setup viewport, orthographic projection matrix
-    // Our visible imgui space lies from draw_data->DisplayPos (top left) to draw_data->DisplayPos+data_data->DisplaySize (bottom right). DisplayPos is (0,0) for single viewport apps.
-    GL_CALL(glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height));
-    float L = draw_data->DisplayPos.x;
-    float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
-    float T = draw_data->DisplayPos.y;
-    float B = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+    int viewport_x = 0, viewport_y = 0, viewport_w = fb_width, viewport_h = fb_height;
+    ImGui_ImplOpenGL3_RotateRect(bd->FramebufferRotation, fb_width, fb_height, &viewport_x, &viewport_y, &viewport_w, &viewport_h);
+    GL_CALL(glViewport(0, 0, (GLsizei)viewport_w, (GLsizei)viewport_h));
+    float ortho_projection[4][4];
 #if defined(GL_CLIP_ORIGIN)
-    if (!clip_origin_lower_left) { float tmp = T; T = B; B = tmp; } // Swap top and bottom if origin is upper left
+    ImGui_ImplOpenGL3_GetProjection(draw_data, bd->FramebufferRotation, clip_origin_lower_left, ortho_projection);
+#else
+    ImGui_ImplOpenGL3_GetProjection(draw_data, bd->FramebufferRotation, true, ortho_projection);
 #endif
-    const float ortho_projection[4][4] =
-    {
-        { 2.0f/(R-L),   0.0f,         0.0f,   0.0f },
-        { 0.0f,         2.0f/(T-B),   0.0f,   0.0f },
-        { 0.0f,         0.0f,        -1.0f,   0.0f },
-        { (R+L)/(L-R),  (T+B)/(B-T),  0.0f,   1.0f },
-    };
     glUseProgram(bd->ShaderHandle);
     glUniform1i(bd->AttribLocationTex, 0);
     glUniformMatrix4fv(bd->AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
@@ -523,6 +734,379 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, col)));
 }
 
+// Owned context: all draw lists of a frame are uploaded back to back. With 'rebase', indices are made relative to the
+// frame's first vertex, so one base vertex serves the whole frame and commands can be merged across draw lists.
+static void ImGui_ImplOpenGL3_CopyDrawData(ImDrawData* draw_data, ImDrawVert* vtx_dst, ImDrawIdx* idx_dst, bool rebase)
+{
+    unsigned int vtx_base = 0;
+    for (const ImDrawList* draw_list : draw_data->CmdLists)
+    {
+        memcpy(vtx_dst, draw_list->VtxBuffer.Data, (size_t)draw_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        if (!rebase || vtx_base == 0)
+            memcpy(idx_dst, draw_list->IdxBuffer.Data, (size_t)draw_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        else
+            for (int n = 0; n < draw_list->IdxBuffer.Size; n++)
+                idx_dst[n] = (ImDrawIdx)(draw_list->IdxBuffer.Data[n] + vtx_base);
+        vtx_dst += draw_list->VtxBuffer.Size;
+        idx_dst += draw_list->IdxBuffer.Size;
+        vtx_base += (unsigned int)draw_list->VtxBuffer.Size;
+    }
+}
+
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+// Stream buffer: each frame's vertices and indices are written behind the previous frame's, unsynchronized, and fenced.
+// A part is only written again after its fence signaled. Orphaning on growth leaves frames in flight their old storage.
+static void ImGui_ImplOpenGL3_StreamRetireOldest(ImGui_ImplOpenGL3_Data* bd, bool* waited)
+{
+    ImGui_ImplOpenGL3_StreamSegment& segment = bd->StreamSegments[0];
+    GLenum result = glClientWaitSync(segment.Fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        *waited = true;
+        do
+            result = glClientWaitSync(segment.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms
+        while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(segment.Fence);
+    bd->StreamSegmentCount--;
+    memmove(&bd->StreamSegments[0], &bd->StreamSegments[1], (size_t)bd->StreamSegmentCount * sizeof(segment));
+}
+
+static void ImGui_ImplOpenGL3_StreamRelease(ImGui_ImplOpenGL3_Data* bd)
+{
+    for (int n = 0; n < bd->StreamSegmentCount; n++)
+        glDeleteSync(bd->StreamSegments[n].Fence);
+    bd->StreamSegmentCount = 0;
+    bd->StreamHead = 0;
+}
+
+// Returns the offset of 'size' free bytes, on a vertex boundary so vertices are addressed by index from the start of the buffer.
+static GLsizeiptr ImGui_ImplOpenGL3_StreamAllocate(ImGui_ImplOpenGL3_Data* bd, GLsizeiptr size)
+{
+    // Room for three frames of this size, twice as much after a wait, up to eight frames
+    GLsizeiptr capacity = (GLsizeiptr)bd->StreamStats.Capacity;
+    GLsizeiptr wanted = (size * 3 > capacity) ? size * 3 : capacity;
+    if (bd->StreamGrow && capacity < size * 8 && capacity * 2 > wanted)
+        wanted = capacity * 2;
+    bd->StreamGrow = false;
+    if (wanted > capacity)
+    {
+        GLsizeiptr new_capacity = 64 * 1024;
+        while (new_capacity < wanted)
+            new_capacity *= 2;
+        ImGui_ImplOpenGL3_StreamRelease(bd);
+        GL_CALL(glBufferData(GL_ARRAY_BUFFER, new_capacity, nullptr, GL_STREAM_DRAW));
+        if (capacity > 0)
+            bd->StreamStats.Grows++;
+        bd->StreamStats.Capacity = (size_t)new_capacity;
+        capacity = new_capacity;
+    }
+
+    GLsizeiptr offset = (bd->StreamHead + (GLsizeiptr)sizeof(ImDrawVert) - 1) / (GLsizeiptr)sizeof(ImDrawVert) * (GLsizeiptr)sizeof(ImDrawVert);
+    if (offset + size > capacity)
+        offset = 0;
+
+    // Fences signal in order: retiring the oldest until nothing overlaps waits no longer than needed
+    bool waited = false;
+    for (int n = 0; n < bd->StreamSegmentCount; n++)
+        if (bd->StreamSegments[n].Begin < offset + size && offset < bd->StreamSegments[n].End)
+        {
+            ImGui_ImplOpenGL3_StreamRetireOldest(bd, &waited);
+            n = -1;
+        }
+    if (bd->StreamSegmentCount == IM_ARRAYSIZE(bd->StreamSegments))
+        ImGui_ImplOpenGL3_StreamRetireOldest(bd, &waited);
+    if (waited)
+    {
+        bd->StreamStats.Waits++;
+        bd->StreamGrow = true;
+    }
+
+    bd->StreamHead = offset + size;
+    return offset;
+}
+
+// Writes all draw lists, vertices then indices. Returns the first vertex and index of the frame in the buffer.
+static void ImGui_ImplOpenGL3_StreamUpload(ImGui_ImplOpenGL3_Data* bd, ImDrawData* draw_data, bool rebase, unsigned int* out_vtx_offset, unsigned int* out_idx_offset)
+{
+    const GLsizeiptr vtx_size = (GLsizeiptr)draw_data->TotalVtxCount * (GLsizeiptr)sizeof(ImDrawVert);
+    const GLsizeiptr idx_size = (GLsizeiptr)draw_data->TotalIdxCount * (GLsizeiptr)sizeof(ImDrawIdx);
+    const GLsizeiptr offset = ImGui_ImplOpenGL3_StreamAllocate(bd, vtx_size + idx_size);
+
+    char* dst = (char*)glMapBufferRange(GL_ARRAY_BUFFER, offset, vtx_size + idx_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst != nullptr)
+        ImGui_ImplOpenGL3_CopyDrawData(draw_data, (ImDrawVert*)dst, (ImDrawIdx*)(dst + vtx_size), rebase);
+    if (dst == nullptr || glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
+    {
+        // Mapping failed or the contents got lost: write the same range from a copy
+        bd->OwnedVtxBuffer.resize(draw_data->TotalVtxCount);
+        bd->OwnedIdxBuffer.resize(draw_data->TotalIdxCount);
+        ImGui_ImplOpenGL3_CopyDrawData(draw_data, bd->OwnedVtxBuffer.Data, bd->OwnedIdxBuffer.Data, rebase);
+        GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, offset, vtx_size, (const GLvoid*)bd->OwnedVtxBuffer.Data));
+        GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, offset + vtx_size, idx_size, (const GLvoid*)bd->OwnedIdxBuffer.Data));
+        bd->StreamStats.Fallbacks++;
+    }
+    bd->StreamStats.Frames++;
+
+    *out_vtx_offset = (unsigned int)(offset / (GLsizeiptr)sizeof(ImDrawVert));
+    *out_idx_offset = (unsigned int)((offset + vtx_size) / (GLsizeiptr)sizeof(ImDrawIdx));
+}
+
+// After the frame's draws: the GPU reads the frame's part, from 'begin' up to the head, until this fence signals
+static void ImGui_ImplOpenGL3_StreamFence(ImGui_ImplOpenGL3_Data* bd, GLsizeiptr begin)
+{
+    ImGui_ImplOpenGL3_StreamSegment& segment = bd->StreamSegments[bd->StreamSegmentCount++];
+    segment.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    segment.Begin = begin;
+    segment.End = bd->StreamHead;
+}
+#endif
+
+// Owned context: the pipeline state is set once and stays in place across frames, until ImGui_ImplOpenGL3_InvalidateRenderState().
+static void ImGui_ImplOpenGL3_PointOwnedVtxAttribs(ImGui_ImplOpenGL3_Data* bd, GLsizeiptr offset)
+{
+    GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxPos,   2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (GLvoid*)(offset + offsetof(ImDrawVert, pos))));
+    GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxUV,    2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (GLvoid*)(offset + offsetof(ImDrawVert, uv))));
+    GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)(offset + offsetof(ImDrawVert, col))));
+    bd->OwnedVtxAttribOffset = offset;
+}
+
+static void ImGui_ImplOpenGL3_SetupOwnedRenderState(ImGui_ImplOpenGL3_Data* bd)
+{
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_STENCIL_TEST);
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_PRIMITIVE_RESTART
+    if (!bd->GlProfileIsES3 && bd->GlVersion >= 310)
+        glDisable(GL_PRIMITIVE_RESTART);
+#endif
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_POLYGON_MODE
+    if (bd->HasPolygonMode)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+#endif
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(bd->ShaderHandle);
+    glUniform1i(bd->AttribLocationTex, 0);
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
+    if (bd->HasBindSampler)
+        glBindSampler(0, 0);
+#endif
+
+    // One vertex array object for the lifetime of the device objects
+#ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
+    if (bd->OwnedVertexArray == 0)
+        GL_CALL(glGenVertexArrays(1, &bd->OwnedVertexArray));
+    glBindVertexArray(bd->OwnedVertexArray);
+#endif
+    GLuint elements_handle = bd->ElementsHandle;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    if (bd->UseStreamBuffer)
+        elements_handle = bd->VboHandle; // Indices follow the vertices in the stream buffer
+#endif
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
+    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elements_handle));
+    GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxPos));
+    GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxUV));
+    GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxColor));
+    ImGui_ImplOpenGL3_PointOwnedVtxAttribs(bd, 0);
+
+    bd->OwnedViewport[0] = bd->OwnedViewport[1] = -1;
+    memset(bd->OwnedProjection, 0, sizeof(bd->OwnedProjection));
+    bd->OwnedStateValid = true;
+}
+
+// The per-frame part. The application may have cleared with the scissor test off or bound textures of its own since the last frame.
+static void ImGui_ImplOpenGL3_SetupOwnedFrameState(ImGui_ImplOpenGL3_Data* bd, ImDrawData* draw_data, int fb_width, int fb_height)
+{
+    glEnable(GL_SCISSOR_TEST);
+    bd->OwnedScissor[2] = -1;
+    bd->OwnedTexture = 0;
+
+    int viewport_x = 0, viewport_y = 0, viewport_w = fb_width, viewport_h = fb_height;
+    ImGui_ImplOpenGL3_RotateRect(bd->FramebufferRotation, fb_width, fb_height, &viewport_x, &viewport_y, &viewport_w, &viewport_h);
+    if (bd->OwnedViewport[0] != viewport_w || bd->OwnedViewport[1] != viewport_h)
+    {
+        GL_CALL(glViewport(0, 0, (GLsizei)viewport_w, (GLsizei)viewport_h));
+        bd->OwnedViewport[0] = viewport_w;
+        bd->OwnedViewport[1] = viewport_h;
+    }
+
+    float ortho_projection[4][4];
+    ImGui_ImplOpenGL3_GetProjection(draw_data, bd->FramebufferRotation, true, ortho_projection);
+    if (memcmp(ortho_projection, bd->OwnedProjection, sizeof(ortho_projection)) != 0)
+    {
+        glUniformMatrix4fv(bd->AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
+        memcpy(bd->OwnedProjection, ortho_projection, sizeof(ortho_projection));
+    }
+}
+
+static void ImGui_ImplOpenGL3_DrawOwned(ImGui_ImplOpenGL3_Data* bd, unsigned int elem_count, unsigned int idx_offset, unsigned int vtx_offset)
+{
+    const GLenum idx_type = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const void* indices = (const void*)(intptr_t)(idx_offset * sizeof(ImDrawIdx));
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
+    if (bd->GlVersion >= 320)
+    {
+        GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)elem_count, idx_type, indices, (GLint)vtx_offset));
+        return;
+    }
+#endif
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BASE_VERTEX_PROC
+    if (bd->DrawElementsBaseVertex != nullptr)
+    {
+        GL_CALL(bd->DrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)elem_count, idx_type, indices, (GLint)vtx_offset));
+        return;
+    }
+#endif
+    // No base vertex: point the attributes at the first vertex instead
+    const GLsizeiptr vtx_attrib_offset = (GLsizeiptr)vtx_offset * (GLsizeiptr)sizeof(ImDrawVert);
+    if (vtx_attrib_offset != bd->OwnedVtxAttribOffset)
+        ImGui_ImplOpenGL3_PointOwnedVtxAttribs(bd, vtx_attrib_offset);
+    GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)elem_count, idx_type, indices));
+}
+
+// Without the stream buffer: one glBufferData() per buffer, draw lists concatenated first unless there is only one
+static void ImGui_ImplOpenGL3_UploadOwned(ImGui_ImplOpenGL3_Data* bd, ImDrawData* draw_data, bool rebase)
+{
+    const ImDrawVert* vtx_data = nullptr;
+    const ImDrawIdx* idx_data = nullptr;
+    if (draw_data->CmdListsCount == 1)
+    {
+        vtx_data = draw_data->CmdLists[0]->VtxBuffer.Data;
+        idx_data = draw_data->CmdLists[0]->IdxBuffer.Data;
+    }
+    else
+    {
+        bd->OwnedVtxBuffer.resize(draw_data->TotalVtxCount);
+        bd->OwnedIdxBuffer.resize(draw_data->TotalIdxCount);
+        ImGui_ImplOpenGL3_CopyDrawData(draw_data, bd->OwnedVtxBuffer.Data, bd->OwnedIdxBuffer.Data, rebase);
+        vtx_data = bd->OwnedVtxBuffer.Data;
+        idx_data = bd->OwnedIdxBuffer.Data;
+    }
+    GL_CALL(glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)draw_data->TotalVtxCount * (int)sizeof(ImDrawVert), (const GLvoid*)vtx_data, GL_STREAM_DRAW));
+    GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)draw_data->TotalIdxCount * (int)sizeof(ImDrawIdx), (const GLvoid*)idx_data, GL_STREAM_DRAW));
+}
+
+// Pre-pass: commands become batches. Consecutive commands with the same texture and scissor whose indices follow each other
+// in the buffer are drawn together, also across draw lists once indices are frame relative. Clipped away commands are dropped.
+static void ImGui_ImplOpenGL3_BuildOwnedBatches(ImGui_ImplOpenGL3_Data* bd, ImDrawData* draw_data, int fb_width, int fb_height, unsigned int vtx_offset, unsigned int idx_offset, bool rebase)
+{
+    ImVector<ImGui_ImplOpenGL3_Batch>& batches = bd->OwnedBatches;
+    batches.resize(0);
+
+    ImVec2 clip_off = draw_data->DisplayPos;
+    ImVec2 clip_scale = draw_data->FramebufferScale;
+    unsigned int list_vtx_offset = vtx_offset;
+    unsigned int list_idx_offset = idx_offset;
+    for (const ImDrawList* draw_list : draw_data->CmdLists)
+    {
+        for (int cmd_i = 0; cmd_i < draw_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &draw_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback != nullptr)
+            {
+                ImGui_ImplOpenGL3_Batch batch = {};
+                batch.CallbackList = draw_list;
+                batch.CallbackCmd = pcmd;
+                batches.push_back(batch);
+                continue;
+            }
+
+            ImVec2 clip_min((pcmd->ClipRect.x - clip_off.x) * clip_scale.x, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
+            ImVec2 clip_max((pcmd->ClipRect.z - clip_off.x) * clip_scale.x, (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
+            if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
+                continue;
+
+            ImGui_ImplOpenGL3_Batch batch = {};
+            batch.Scissor[0] = (int)clip_min.x;
+            batch.Scissor[1] = (int)((float)fb_height - clip_max.y);
+            batch.Scissor[2] = (int)(clip_max.x - clip_min.x);
+            batch.Scissor[3] = (int)(clip_max.y - clip_min.y);
+            ImGui_ImplOpenGL3_RotateRect(bd->FramebufferRotation, fb_width, fb_height, &batch.Scissor[0], &batch.Scissor[1], &batch.Scissor[2], &batch.Scissor[3]);
+            batch.Texture = (GLuint)(intptr_t)pcmd->GetTexID();
+            batch.IdxOffset = list_idx_offset + pcmd->IdxOffset;
+            batch.ElemCount = pcmd->ElemCount;
+            batch.VtxOffset = (rebase ? vtx_offset : list_vtx_offset) + pcmd->VtxOffset;
+            bd->RenderStats.Commands++;
+
+            if (!batches.empty())
+            {
+                ImGui_ImplOpenGL3_Batch& last = batches.back();
+                if (last.CallbackCmd == nullptr && last.Texture == batch.Texture && last.VtxOffset == batch.VtxOffset &&
+                    last.IdxOffset + last.ElemCount == batch.IdxOffset && memcmp(last.Scissor, batch.Scissor, sizeof(batch.Scissor)) == 0)
+                {
+                    last.ElemCount += batch.ElemCount;
+                    continue;
+                }
+            }
+            batches.push_back(batch);
+        }
+        list_vtx_offset += (unsigned int)draw_list->VtxBuffer.Size;
+        list_idx_offset += (unsigned int)draw_list->IdxBuffer.Size;
+    }
+}
+
+static void ImGui_ImplOpenGL3_RenderDrawDataOwned(ImGui_ImplOpenGL3_Data* bd, ImDrawData* draw_data, int fb_width, int fb_height)
+{
+    if (!bd->OwnedStateValid)
+        ImGui_ImplOpenGL3_SetupOwnedRenderState(bd);
+    ImGui_ImplOpenGL3_SetupOwnedFrameState(bd, draw_data, fb_width, fb_height);
+    bd->RenderStats.Frames++;
+
+    // Upload all draw lists at once, a list is drawn from its offset into the shared buffers.
+    // Frame relative indices need the whole frame addressable by ImDrawIdx.
+    const bool rebase = sizeof(ImDrawIdx) == 4 || draw_data->TotalVtxCount <= 0x10000;
+    unsigned int vtx_offset = 0;
+    unsigned int idx_offset = 0;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    const bool stream = bd->UseStreamBuffer && draw_data->TotalVtxCount > 0;
+    if (stream)
+        ImGui_ImplOpenGL3_StreamUpload(bd, draw_data, rebase, &vtx_offset, &idx_offset);
+    if (!bd->UseStreamBuffer)
+#endif
+        ImGui_ImplOpenGL3_UploadOwned(bd, draw_data, rebase);
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    const GLsizeiptr stream_begin = (GLsizeiptr)vtx_offset * (GLsizeiptr)sizeof(ImDrawVert);
+#endif
+
+    ImGui_ImplOpenGL3_BuildOwnedBatches(bd, draw_data, fb_width, fb_height, vtx_offset, idx_offset, rebase);
+    for (const ImGui_ImplOpenGL3_Batch& batch : bd->OwnedBatches)
+    {
+        if (batch.CallbackCmd != nullptr)
+        {
+            // Whatever a callback changed, the owned state is set up again after it
+            if (batch.CallbackCmd->UserCallback != ImDrawCallback_ResetRenderState)
+                batch.CallbackCmd->UserCallback(batch.CallbackList, batch.CallbackCmd);
+            ImGui_ImplOpenGL3_SetupOwnedRenderState(bd);
+            ImGui_ImplOpenGL3_SetupOwnedFrameState(bd, draw_data, fb_width, fb_height);
+            continue;
+        }
+
+        if (memcmp(batch.Scissor, bd->OwnedScissor, sizeof(batch.Scissor)) != 0)
+        {
+            GL_CALL(glScissor(batch.Scissor[0], batch.Scissor[1], batch.Scissor[2], batch.Scissor[3]));
+            memcpy(bd->OwnedScissor, batch.Scissor, sizeof(batch.Scissor));
+            bd->RenderStats.ScissorChanges++;
+        }
+        if (batch.Texture != bd->OwnedTexture)
+        {
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, batch.Texture));
+            bd->OwnedTexture = batch.Texture;
+            bd->RenderStats.TextureChanges++;
+        }
+        ImGui_ImplOpenGL3_DrawOwned(bd, batch.ElemCount, batch.IdxOffset, batch.VtxOffset);
+        bd->RenderStats.DrawCalls++;
+    }
+
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    if (stream)
+        ImGui_ImplOpenGL3_StreamFence(bd, stream_begin);
+#endif
+}
+
 // OpenGL3 Render function.
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly.
 // This is in order to be able to run within an OpenGL engine that doesn't do so.
@@ -540,10 +1124,22 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
 
     // Catch up with texture updates. Most of the times, the list will have 1 element with an OK status, aka nothing to do.
     // (This almost always points to ImGui::GetPlatformIO().Textures[] but is part of ImDrawData to allow overriding or disabling texture updates).
+    // (AImGui: on ES 3, creations and updates go through a pixel unpack buffer first; what is left, destroys included, goes the direct way)
     if (draw_data->Textures != nullptr)
+    {
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+        ImGui_ImplOpenGL3_StageTextureUploads(bd, *draw_data->Textures);
+#endif
         for (ImTextureData* tex : *draw_data->Textures)
             if (tex->Status != ImTextureStatus_OK)
                 ImGui_ImplOpenGL3_UpdateTexture(tex);
+    }
+
+    if (bd->OwnedContext)
+    {
+        ImGui_ImplOpenGL3_RenderDrawDataOwned(bd, draw_data, fb_width, fb_height);
+        return;
+    }
 
     // Backup GL state
     GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
@@ -597,6 +1193,11 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
     ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
     ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
 
+    // Scissor box and texture set by the previous command, unknown after a user callback
+    int last_cmd_scissor[4] = { 0, 0, -1, -1 };
+    GLuint last_cmd_texture = 0;
+    bd->RenderStats.Frames++;
+
     // Render command lists
     for (const ImDrawList* draw_list : draw_data->CmdLists)
     {
@@ -642,6 +1243,8 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                     ImGui_ImplOpenGL3_SetupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
                 else
                     pcmd->UserCallback(draw_list, pcmd);
+                last_cmd_scissor[2] = -1;
+                last_cmd_texture = 0;
             }
             else
             {
@@ -652,10 +1255,26 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                     continue;
 
                 // Apply scissor/clipping rectangle (Y is inverted in OpenGL)
-                GL_CALL(glScissor((int)clip_min.x, (int)((float)fb_height - clip_max.y), (int)(clip_max.x - clip_min.x), (int)(clip_max.y - clip_min.y)));
+                int scissor_x = (int)clip_min.x, scissor_y = (int)((float)fb_height - clip_max.y), scissor_w = (int)(clip_max.x - clip_min.x), scissor_h = (int)(clip_max.y - clip_min.y);
+                ImGui_ImplOpenGL3_RotateRect(bd->FramebufferRotation, fb_width, fb_height, &scissor_x, &scissor_y, &scissor_w, &scissor_h);
+                const int scissor[4] = { scissor_x, scissor_y, scissor_w, scissor_h };
+                if (memcmp(scissor, last_cmd_scissor, sizeof(scissor)) != 0)
+                {
+                    GL_CALL(glScissor(scissor_x, scissor_y, scissor_w, scissor_h));
+                    memcpy(last_cmd_scissor, scissor, sizeof(scissor));
+                    bd->RenderStats.ScissorChanges++;
+                }
 
                 // Bind texture, Draw
-                GL_CALL(glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->GetTexID()));
+                const GLuint texture = (GLuint)(intptr_t)pcmd->GetTexID();
+                if (texture != last_cmd_texture)
+                {
+                    GL_CALL(glBindTexture(GL_TEXTURE_2D, texture));
+                    last_cmd_texture = texture;
+                    bd->RenderStats.TextureChanges++;
+                }
+                bd->RenderStats.Commands++;
+                bd->RenderStats.DrawCalls++;
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
                 if (bd->GlVersion >= 320)
                     GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)), (GLint)pcmd->VtxOffset));
@@ -721,8 +1340,25 @@ static void ImGui_ImplOpenGL3_DestroyTexture(ImTextureData* tex)
     tex->SetStatus(ImTextureStatus_Destroyed);
 }
 
+// Create the texture object and allocate it with the given pixels (a pixel unpack buffer offset when one is bound). Leaves it bound.
+static GLuint ImGui_ImplOpenGL3_CreateTextureObject(ImTextureData* tex, const void* pixels)
+{
+    // (Bilinear sampling is required by default. Set 'io.Fonts->Flags |= ImFontAtlasFlags_NoBakedLines' or 'style.AntiAliasedLinesUseTex = false' to allow point/nearest sampling)
+    GLuint gl_texture_id = 0;
+    GL_CALL(glGenTextures(1, &gl_texture_id));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, gl_texture_id));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex->Width, tex->Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    return gl_texture_id;
+}
+
 void ImGui_ImplOpenGL3_UpdateTexture(ImTextureData* tex)
 {
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+
     // FIXME: Consider backing up and restoring
     if (tex->Status == ImTextureStatus_WantCreate || tex->Status == ImTextureStatus_WantUpdates)
     {
@@ -741,33 +1377,33 @@ void ImGui_ImplOpenGL3_UpdateTexture(ImTextureData* tex)
         IM_ASSERT(tex->TexID == 0 && tex->BackendUserData == nullptr);
         IM_ASSERT(tex->Format == ImTextureFormat_RGBA32);
         const void* pixels = tex->GetPixels();
-        GLuint gl_texture_id = 0;
 
         // Upload texture to graphics system
-        // (Bilinear sampling is required by default. Set 'io.Fonts->Flags |= ImFontAtlasFlags_NoBakedLines' or 'style.AntiAliasedLinesUseTex = false' to allow point/nearest sampling)
-        GLint last_texture;
-        GL_CALL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture));
-        GL_CALL(glGenTextures(1, &gl_texture_id));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, gl_texture_id));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex->Width, tex->Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+        // (Owned context: no backup, the texture stays bound)
+        GLint last_texture = 0;
+        if (!bd->OwnedContext)
+            GL_CALL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture));
+        GLuint gl_texture_id = ImGui_ImplOpenGL3_CreateTextureObject(tex, pixels);
+        bd->RenderStats.TextureUploads++;
+        bd->RenderStats.TextureUploadBytes += (ImU64)tex->GetSizeInBytes();
 
         // Store identifiers
         tex->SetTexID((ImTextureID)(intptr_t)gl_texture_id);
         tex->SetStatus(ImTextureStatus_OK);
 
         // Restore state
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, last_texture));
+        if (bd->OwnedContext)
+            bd->OwnedTexture = gl_texture_id;
+        else
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, last_texture));
     }
     else if (tex->Status == ImTextureStatus_WantUpdates)
     {
         // Update selected blocks. We only ever write to textures regions which have never been used before!
         // This backend choose to use tex->Updates[] but you can use tex->UpdateRect to upload a single region.
-        GLint last_texture;
-        GL_CALL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture));
+        GLint last_texture = 0;
+        if (!bd->OwnedContext)
+            GL_CALL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture));
 
         GLuint gl_tex_id = (GLuint)(intptr_t)tex->TexID;
         GL_CALL(glBindTexture(GL_TEXTURE_2D, gl_tex_id));
@@ -778,7 +1414,6 @@ void ImGui_ImplOpenGL3_UpdateTexture(ImTextureData* tex)
         GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
 #else
         // GL ES doesn't have GL_UNPACK_ROW_LENGTH, so we need to (A) copy to a contiguous buffer or (B) upload line by line.
-        ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
         for (ImTextureRect& r : tex->Updates)
         {
             const int src_pitch = r.w * tex->BytesPerPixel;
@@ -790,13 +1425,179 @@ void ImGui_ImplOpenGL3_UpdateTexture(ImTextureData* tex)
             GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.w, r.h, GL_RGBA, GL_UNSIGNED_BYTE, bd->TempBuffer.Data));
         }
 #endif
+        for (ImTextureRect& r : tex->Updates)
+            bd->RenderStats.TextureUploadBytes += (ImU64)r.w * r.h * tex->BytesPerPixel;
+        bd->RenderStats.TextureUploads += (ImU64)tex->Updates.Size;
         tex->SetStatus(ImTextureStatus_OK);
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, last_texture)); // Restore state
+        if (bd->OwnedContext)
+            bd->OwnedTexture = gl_tex_id;
+        else
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, last_texture)); // Restore state
     }
     else if (tex->Status == ImTextureStatus_WantDestroy && tex->UnusedFrames > 0)
         ImGui_ImplOpenGL3_DestroyTexture(tex);
 }
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+// Rectangles to upload for a pending update: the bounding box alone when it is at most twice the area of the updates.
+// (Glyphs baked in one frame are packed close together, and every upload call from a pixel unpack buffer has a fixed cost)
+static int ImGui_ImplOpenGL3_GetUploadRects(const ImTextureData* tex, const ImTextureRect** out_rects)
+{
+    size_t area = 0;
+    for (const ImTextureRect& r : tex->Updates)
+        area += (size_t)r.w * r.h;
+    if (tex->Updates.Size > 1 && (size_t)tex->UpdateRect.w * tex->UpdateRect.h <= area * 2)
+    {
+        *out_rects = &tex->UpdateRect;
+        return 1;
+    }
+    *out_rects = tex->Updates.Data;
+    return tex->Updates.Size;
+}
+
+// Bytes a pending creation or update stages, rows tightly packed
+static size_t ImGui_ImplOpenGL3_GetUploadSize(const ImTextureData* tex)
+{
+    size_t size = 0;
+    if (tex->Status == ImTextureStatus_WantCreate)
+        size = (size_t)tex->GetSizeInBytes();
+    else if (tex->Status == ImTextureStatus_WantUpdates)
+    {
+        const ImTextureRect* rects = nullptr;
+        for (int n = ImGui_ImplOpenGL3_GetUploadRects(tex, &rects) - 1; n >= 0; n--)
+            size += (size_t)rects[n].w * rects[n].h * tex->BytesPerPixel;
+    }
+    return size;
+}
+
+// Copy the pixels of every pending creation and update into one pixel unpack buffer, then let glTexImage2D()/glTexSubImage2D()
+// read them from there: the calls return without copying, the transfer is ordered with the draws like any other GPU command.
+// The buffers are used in turn so the one mapped was last read frames ago. Should the GPU still read it, mapping with
+// GL_MAP_INVALIDATE_BUFFER_BIT lets the driver hand out new storage instead of waiting. (No fences: on some drivers
+// glFenceSync() flushes, which costs more than the copy of a few glyphs)
+// When the buffer can't be mapped nothing is staged and the textures are left to ImGui_ImplOpenGL3_UpdateTexture().
+static void ImGui_ImplOpenGL3_StageTextureUploads(ImGui_ImplOpenGL3_Data* bd, ImVector<ImTextureData*>& textures)
+{
+    size_t total_size = 0;
+    for (ImTextureData* tex : textures)
+        total_size += ImGui_ImplOpenGL3_GetUploadSize(tex);
+    if (total_size == 0)
+        return;
+
+    GLint last_texture = 0, last_pixel_unpack_buffer = 0;
+    if (!bd->OwnedContext)
+    {
+        GL_CALL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture));
+        GL_CALL(glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &last_pixel_unpack_buffer));
+    }
+
+    const int slot = bd->UploadBufferIndex;
+    bd->UploadBufferIndex = (slot + 1) % IM_ARRAYSIZE(bd->UploadBuffers);
+    if (bd->UploadBuffers[slot] == 0)
+        GL_CALL(glGenBuffers(1, &bd->UploadBuffers[slot]));
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bd->UploadBuffers[slot]));
+
+    // Power of two sizes from 64 KiB. A buffer grown for a whole atlas shrinks again once the uploads are back to a few glyphs.
+    GLsizeiptr size = 64 * 1024;
+    while (size < (GLsizeiptr)total_size)
+        size *= 2;
+    if (bd->UploadBufferSizes[slot] < size || bd->UploadBufferSizes[slot] > size * 8)
+    {
+        GL_CALL(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+        bd->UploadBufferSizes[slot] = size;
+    }
+    char* dst = (char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)total_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst != nullptr)
+    {
+        for (ImTextureData* tex : textures)
+        {
+            if (tex->Status == ImTextureStatus_WantCreate)
+            {
+                memcpy(dst, tex->GetPixels(), (size_t)tex->GetSizeInBytes());
+                dst += tex->GetSizeInBytes();
+            }
+            else if (tex->Status == ImTextureStatus_WantUpdates)
+            {
+                const ImTextureRect* rects = nullptr;
+                const int rects_count = ImGui_ImplOpenGL3_GetUploadRects(tex, &rects);
+                for (int n = 0; n < rects_count; n++)
+                {
+                    const ImTextureRect& r = rects[n];
+                    for (int y = 0; y < r.h; y++, dst += r.w * tex->BytesPerPixel)
+                        memcpy(dst, tex->GetPixelsAt(r.x, r.y + y), (size_t)r.w * tex->BytesPerPixel);
+                }
+            }
+        }
+    }
+    if (dst == nullptr || glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+    {
+        // Contents undefined, the buffer gets new storage next time it is used
+        bd->UploadBufferSizes[slot] = 0;
+        GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, (GLuint)last_pixel_unpack_buffer));
+        return;
+    }
+
+    // Pixels are read at buffer offsets, rows tightly packed
+    GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GLuint gl_texture_id = 0;
+    size_t offset = 0;
+    for (ImTextureData* tex : textures)
+    {
+        if (tex->Status == ImTextureStatus_WantCreate)
+        {
+            IM_ASSERT(tex->TexID == 0 && tex->BackendUserData == nullptr);
+            IM_ASSERT(tex->Format == ImTextureFormat_RGBA32);
+            gl_texture_id = ImGui_ImplOpenGL3_CreateTextureObject(tex, (const void*)offset);
+            offset += (size_t)tex->GetSizeInBytes();
+            tex->SetTexID((ImTextureID)(intptr_t)gl_texture_id);
+            bd->RenderStats.TextureUploads++;
+        }
+        else if (tex->Status == ImTextureStatus_WantUpdates)
+        {
+            gl_texture_id = (GLuint)(intptr_t)tex->TexID;
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, gl_texture_id));
+            const ImTextureRect* rects = nullptr;
+            const int rects_count = ImGui_ImplOpenGL3_GetUploadRects(tex, &rects);
+            for (int n = 0; n < rects_count; n++)
+            {
+                const ImTextureRect& r = rects[n];
+                GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.w, r.h, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)offset));
+                offset += (size_t)r.w * r.h * tex->BytesPerPixel;
+            }
+            bd->RenderStats.TextureUploads += (ImU64)rects_count;
+        }
+        else
+        {
+            continue;
+        }
+        tex->SetStatus(ImTextureStatus_OK);
+    }
+    IM_ASSERT(offset == total_size);
+    bd->RenderStats.TextureUploadBytes += (ImU64)total_size;
+    bd->RenderStats.StagedUploadBytes += (ImU64)total_size;
+
+    // Restore state. (Owned context: client memory uploads expect no pixel unpack buffer, the last texture stays bound)
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, (GLuint)last_pixel_unpack_buffer));
+    if (bd->OwnedContext)
+        bd->OwnedTexture = gl_texture_id;
+    else
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, last_texture));
+}
+
+static void ImGui_ImplOpenGL3_UploadRelease(ImGui_ImplOpenGL3_Data* bd)
+{
+    for (int n = 0; n < IM_ARRAYSIZE(bd->UploadBuffers); n++)
+    {
+        if (bd->UploadBuffers[n] != 0)
+            glDeleteBuffers(1, &bd->UploadBuffers[n]);
+        bd->UploadBuffers[n] = 0;
+        bd->UploadBufferSizes[n] = 0;
+    }
+    bd->UploadBufferIndex = 0;
+}
+#endif
+
 // If you get an error please report on github. You may try different GL context version or GLSL version. See GL<>GLSL version table at the top of this file.
 static bool CheckShader(GLuint handle, const char* desc)
 {
@@ -835,6 +1636,44 @@ static bool CheckProgram(GLuint handle, const char* desc)
     return (GLboolean)status == GL_TRUE;
 }
 
+// Compiles the shaders and links them into bd->ShaderHandle.
+static bool ImGui_ImplOpenGL3_CompileProgram(ImGui_ImplOpenGL3_Data* bd, const GLchar* vertex_shader, const GLchar* fragment_shader)
+{
+    // Create shaders
+    const GLchar* vertex_shader_with_version[2] = { bd->GlslVersionString, vertex_shader };
+    GLuint vert_handle;
+    GL_CALL(vert_handle = glCreateShader(GL_VERTEX_SHADER));
+    glShaderSource(vert_handle, 2, vertex_shader_with_version, nullptr);
+    glCompileShader(vert_handle);
+    if (!CheckShader(vert_handle, "vertex shader"))
+        return false;
+
+    const GLchar* fragment_shader_with_version[2] = { bd->GlslVersionString, fragment_shader };
+    GLuint frag_handle;
+    GL_CALL(frag_handle = glCreateShader(GL_FRAGMENT_SHADER));
+    glShaderSource(frag_handle, 2, fragment_shader_with_version, nullptr);
+    glCompileShader(frag_handle);
+    if (!CheckShader(frag_handle, "fragment shader"))
+        return false;
+
+    // Link
+#ifdef IMGUI_IMPL_OPENGL_ES3
+    if (bd->ProgramCache.Save)
+        glProgramParameteri(bd->ShaderHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+    glAttachShader(bd->ShaderHandle, vert_handle);
+    glAttachShader(bd->ShaderHandle, frag_handle);
+    glLinkProgram(bd->ShaderHandle);
+    if (!CheckProgram(bd->ShaderHandle, "shader program"))
+        return false;
+
+    glDetachShader(bd->ShaderHandle, vert_handle);
+    glDetachShader(bd->ShaderHandle, frag_handle);
+    glDeleteShader(vert_handle);
+    glDeleteShader(frag_handle);
+    return true;
+}
+
 bool    ImGui_ImplOpenGL3_CreateDeviceObjects()
 {
     ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
@@ -980,35 +1819,16 @@ bool    ImGui_ImplOpenGL3_CreateDeviceObjects()
         fragment_shader = fragment_shader_glsl_130;
     }
 
-    // Create shaders
-    const GLchar* vertex_shader_with_version[2] = { bd->GlslVersionString, vertex_shader };
-    GLuint vert_handle;
-    GL_CALL(vert_handle = glCreateShader(GL_VERTEX_SHADER));
-    glShaderSource(vert_handle, 2, vertex_shader_with_version, nullptr);
-    glCompileShader(vert_handle);
-    if (!CheckShader(vert_handle, "vertex shader"))
-        return false;
-
-    const GLchar* fragment_shader_with_version[2] = { bd->GlslVersionString, fragment_shader };
-    GLuint frag_handle;
-    GL_CALL(frag_handle = glCreateShader(GL_FRAGMENT_SHADER));
-    glShaderSource(frag_handle, 2, fragment_shader_with_version, nullptr);
-    glCompileShader(frag_handle);
-    if (!CheckShader(frag_handle, "fragment shader"))
-        return false;
-
-    // Link
+    // Link from the program cache when it holds a binary for this driver, compile from source otherwise
     bd->ShaderHandle = glCreateProgram();
-    glAttachShader(bd->ShaderHandle, vert_handle);
-    glAttachShader(bd->ShaderHandle, frag_handle);
-    glLinkProgram(bd->ShaderHandle);
-    if (!CheckProgram(bd->ShaderHandle, "shader program"))
-        return false;
-
-    glDetachShader(bd->ShaderHandle, vert_handle);
-    glDetachShader(bd->ShaderHandle, frag_handle);
-    glDeleteShader(vert_handle);
-    glDeleteShader(frag_handle);
+    const ImGui_ImplOpenGL3_ProgramCache& cache = bd->ProgramCache;
+    if (!cache.Load || !cache.Load(cache.UserData, bd->ShaderHandle, bd->GlslVersionString, vertex_shader, fragment_shader))
+    {
+        if (!ImGui_ImplOpenGL3_CompileProgram(bd, vertex_shader, fragment_shader))
+            return false;
+        if (cache.Save)
+            cache.Save(cache.UserData, bd->ShaderHandle, bd->GlslVersionString, vertex_shader, fragment_shader);
+    }
 
     bd->AttribLocationTex = glGetUniformLocation(bd->ShaderHandle, "Texture");
     bd->AttribLocationProjMtx = glGetUniformLocation(bd->ShaderHandle, "ProjMtx");
@@ -1029,6 +1849,7 @@ bool    ImGui_ImplOpenGL3_CreateDeviceObjects()
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     glBindVertexArray(last_vertex_array);
 #endif
+    bd->OwnedStateValid = false;
 
     return true;
 }
@@ -1039,6 +1860,15 @@ void    ImGui_ImplOpenGL3_DestroyDeviceObjects()
     if (bd->VboHandle)      { glDeleteBuffers(1, &bd->VboHandle); bd->VboHandle = 0; }
     if (bd->ElementsHandle) { glDeleteBuffers(1, &bd->ElementsHandle); bd->ElementsHandle = 0; }
     if (bd->ShaderHandle)   { glDeleteProgram(bd->ShaderHandle); bd->ShaderHandle = 0; }
+#ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
+    if (bd->OwnedVertexArray) { glDeleteVertexArrays(1, &bd->OwnedVertexArray); bd->OwnedVertexArray = 0; }
+#endif
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_STREAM_BUFFER
+    ImGui_ImplOpenGL3_StreamRelease(bd);
+    ImGui_ImplOpenGL3_UploadRelease(bd);
+#endif
+    bd->StreamStats.Capacity = 0;
+    bd->OwnedStateValid = false;
 
     // Destroy all textures
     for (ImTextureData* tex : ImGui::GetPlatformIO().Textures)
@@ -43,6 +43,63 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyDeviceObjects();
 // (Advanced) Use e.g. if you need to precisely control the timing of texture updates (e.g. for staged rendering), by setting ImDrawData::Textures = NULL to handle this manually.
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_UpdateTexture(ImTextureData* tex);
 
+// (AImGui) Pre-rotation: render the output turned 'quarter_turns' x 90 degrees clockwise into a framebuffer of swapped size when odd.
+// DisplaySize/FramebufferScale and clip rectangles stay in unrotated display space.
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetFramebufferRotation(int quarter_turns);
+// (AImGui) Moves a framebuffer rectangle (x, y, w, h, bottom-left origin) of the unrotated fb_width x fb_height output to where
+// it lands when rendered with ImGui_ImplOpenGL3_SetFramebufferRotation(quarter_turns), e.g. for glScissor() or swap damage.
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_RotateRect(int quarter_turns, int fb_width, int fb_height, int* x, int* y, int* w, int* h);
+
+// (AImGui) Program binary cache, consulted by ImGui_ImplOpenGL3_CreateDeviceObjects(). 'Load' gets a fresh program and
+// the shader sources and returns true once the program is linked (e.g. through glProgramBinary), false to compile from
+// source. 'Save' then gets the program linked from source. Call after ImGui_ImplOpenGL3_Init(), nullptr to disable.
+struct ImGui_ImplOpenGL3_ProgramCache
+{
+    bool    (*Load)(void* user_data, unsigned int program, const char* glsl_version, const char* vertex_shader, const char* fragment_shader);
+    void    (*Save)(void* user_data, unsigned int program, const char* glsl_version, const char* vertex_shader, const char* fragment_shader);
+    void*   UserData;
+};
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetProgramCache(const ImGui_ImplOpenGL3_ProgramCache* cache);
+
+// (AImGui) Owned context: the GL context is used by Dear ImGui alone. RenderDrawData() then skips the state backup and restore,
+// keeps one vertex array object and sets the pipeline state once, uploads all draw lists in one go and skips redundant
+// texture, scissor, viewport and projection updates. Between frames the application may bind framebuffers and clear (scissor
+// test, scissor box, clear color); any other GL state change must be followed by ImGui_ImplOpenGL3_InvalidateRenderState().
+// 'get_proc_address' (e.g. eglGetProcAddress) resolves glDrawElementsBaseVertex on ES 3.2 or its OES/EXT extension. Call with the context current.
+typedef void*           (*ImGui_ImplOpenGL3_GetProcAddress)(const char* name);
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetOwnedContext(bool owned, ImGui_ImplOpenGL3_GetProcAddress get_proc_address = nullptr);
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_InvalidateRenderState();
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_HasBaseVertex();
+
+// (AImGui) With an owned GL ES 3 context, vertices and indices of a frame go into one streaming buffer holding several frames,
+// written unsynchronized with glMapBufferRange() and fenced per frame. It grows when a frame does not fit or had to wait for the GPU.
+struct ImGui_ImplOpenGL3_StreamStats
+{
+    size_t          Capacity;       // Bytes
+    int             Frames;         // Uploaded through the stream buffer
+    int             Grows;
+    int             Waits;          // Frames that blocked on a fence
+    int             Fallbacks;      // Frames uploaded with glBufferSubData() after a failed map
+};
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_GetStreamStats(ImGui_ImplOpenGL3_StreamStats* out_stats); // false when the stream buffer is not in use
+
+// (AImGui) Totals since ImGui_ImplOpenGL3_Init(). glScissor()/glBindTexture() are only issued when the value changes. With an owned
+// context, consecutive commands with the same texture and clip rectangle are merged into one draw call, across draw lists too.
+// On GL ES 3, RenderDrawData() stages the texture creations and updates of a frame in one pixel unpack buffer, so the uploads
+// don't block on the copy. ImGui_ImplOpenGL3_UpdateTexture() called directly still uploads from client memory.
+struct ImGui_ImplOpenGL3_RenderStats
+{
+    ImU64           Frames;
+    ImU64           Commands;       // ImDrawCmd drawn, without callbacks and commands clipped away entirely
+    ImU64           DrawCalls;
+    ImU64           ScissorChanges;
+    ImU64           TextureChanges;
+    ImU64           TextureUploads;     // Rectangles uploaded, a texture creation counts as one
+    ImU64           TextureUploadBytes;
+    ImU64           StagedUploadBytes;  // Of those, uploaded from a pixel unpack buffer (GL ES 3)
+};
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_GetRenderStats(ImGui_ImplOpenGL3_RenderStats* out_stats);
+
 // Configuration flags to add in your imconfig file:
 //#define IMGUI_IMPL_OPENGL_ES2     // Enable ES 2 (Auto-detected on Emscripten)
 //#define IMGUI_IMPL_OPENGL_ES3     // Enable ES 3 (Auto-detected on iOS/Android)
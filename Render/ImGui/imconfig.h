@@ -144,3 +144,9 @@ namespace ImGui
     void MyFunction(const char* name, MyMatrix44* mtx);
 }
 */
+
+//---- AImGui: every overlay owns an ImGui context and builds/renders it on its own thread(s), so the current
+// context is per thread. Defined in Render/AImGui.cpp, AImGui makes its context current where it uses it.
+struct ImGuiContext;
+extern thread_local ImGuiContext* AImGuiCurrentContext;
+#define GImGui AImGuiCurrentContext
@@ -0,0 +1,163 @@
+#include "ProgramBinaryCache.hpp"
+#include "DrawDataFingerprint.hpp"
+#include "FrameScheduler.hpp"
+
+#include <imgui_impl_opengl3.h>
+#include <GLES3/gl3.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace android
+{
+    namespace
+    {
+        constexpr uint32_t kMagic = 0x42504941; // "AIPB"
+        constexpr uint32_t kVersion = 1;
+        constexpr uint32_t kMaxBinaryLength = 4 << 20;
+
+        struct FileHeader
+        {
+            uint32_t magic = kMagic;
+            uint32_t version = kVersion;
+            uint64_t key = 0;
+            uint32_t format = 0;
+            uint32_t length = 0;
+            int64_t buildTime = 0;
+        };
+
+        bool IsBinaryFormatSupported(GLenum format)
+        {
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+            if (count <= 0)
+                return false;
+
+            std::vector<GLint> formats(static_cast<size_t>(count));
+            glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+            for (GLint supported : formats)
+                if (static_cast<GLenum>(supported) == format)
+                    return true;
+            return false;
+        }
+
+        uint64_t HashString(const char *string, uint64_t seed)
+        {
+            // The terminator goes in too, so ("ab", "c") and ("a", "bc") differ.
+            return string ? HashBytes(string, strlen(string) + 1, seed) : HashBytes("", 1, seed);
+        }
+    } // namespace
+
+    void ProgramBinaryCache::Attach()
+    {
+        m_stats = Stats{};
+
+        ImGui_ImplOpenGL3_ProgramCache cache{};
+        cache.Load = &ProgramBinaryCache::Load;
+        cache.Save = &ProgramBinaryCache::Save;
+        cache.UserData = this;
+        ImGui_ImplOpenGL3_SetProgramCache(m_path.empty() ? nullptr : &cache);
+    }
+
+    uint64_t ProgramBinaryCache::ComputeKey(const char *glslVersion, const char *vertexShader, const char *fragmentShader)
+    {
+        uint64_t key = HashString(reinterpret_cast<const char *>(glGetString(GL_VENDOR)), kMagic);
+        key = HashString(reinterpret_cast<const char *>(glGetString(GL_RENDERER)), key);
+        key = HashString(reinterpret_cast<const char *>(glGetString(GL_VERSION)), key);
+        key = HashString(glslVersion, key);
+        key = HashString(vertexShader, key);
+        return HashString(fragmentShader, key);
+    }
+
+    bool ProgramBinaryCache::Load(void *userData, unsigned int program, const char *glslVersion, const char *vertexShader, const char *fragmentShader)
+    {
+        auto *self = static_cast<ProgramBinaryCache *>(userData);
+        const int64_t start = SteadyFrameClock::Instance().Now();
+        self->m_buildStart = start;
+
+        FILE *file = fopen(self->m_path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        // Anything unexpected, down to trailing bytes, means the file is not ours to trust.
+        FileHeader header;
+        std::vector<uint8_t> binary;
+        bool valid = 1 == fread(&header, sizeof(header), 1, file) && kMagic == header.magic && kVersion == header.version &&
+                     header.key == ComputeKey(glslVersion, vertexShader, fragmentShader) &&
+                     header.length > 0 && header.length <= kMaxBinaryLength;
+        if (valid)
+        {
+            binary.resize(header.length);
+            valid = 1 == fread(binary.data(), binary.size(), 1, file) && EOF == fgetc(file);
+        }
+        fclose(file);
+
+        if (valid && IsBinaryFormatSupported(header.format))
+        {
+            while (GL_NO_ERROR != glGetError())
+                ;
+            glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            valid = GL_NO_ERROR == glGetError() && GL_TRUE == linked;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        const int64_t end = SteadyFrameClock::Instance().Now();
+        if (!valid)
+        {
+            self->m_stats.rejected = true;
+            self->m_buildStart = end;
+            return false;
+        }
+
+        self->m_stats.loaded = true;
+        self->m_stats.loadTime = end - start;
+        self->m_stats.buildTime = header.buildTime;
+        return true;
+    }
+
+    void ProgramBinaryCache::Save(void *userData, unsigned int program, const char *glslVersion, const char *vertexShader, const char *fragmentShader)
+    {
+        auto *self = static_cast<ProgramBinaryCache *>(userData);
+        self->m_stats.buildTime = SteadyFrameClock::Instance().Now() - self->m_buildStart;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0 || static_cast<uint32_t>(length) > kMaxBinaryLength)
+            return;
+
+        FileHeader header;
+        std::vector<uint8_t> binary(static_cast<size_t>(length));
+        GLsizei written = 0;
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &written, &format, binary.data());
+        if (written <= 0)
+            return;
+
+        header.key = ComputeKey(glslVersion, vertexShader, fragmentShader);
+        header.format = format;
+        header.length = static_cast<uint32_t>(written);
+        header.buildTime = self->m_stats.buildTime;
+
+        // Written aside and renamed over the old file, so a reader never sees half of it.
+        char temporary[512];
+        snprintf(temporary, sizeof(temporary), "%s.%p.tmp", self->m_path.c_str(), static_cast<void *>(self));
+        FILE *file = fopen(temporary, "wb");
+        if (!file)
+            return;
+
+        bool complete = 1 == fwrite(&header, sizeof(header), 1, file) && 1 == fwrite(binary.data(), header.length, 1, file);
+        complete &= 0 == fclose(file);
+        if (complete && 0 == rename(temporary, self->m_path.c_str()))
+            self->m_stats.saved = true;
+        else
+            remove(temporary);
+    }
+
+} // namespace android
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace android
+{
+    // Keeps the linked ImGui shader program in a file, so later starts skip compiling and
+    // linking (glProgramBinary instead of glCompileShader/glLinkProgram). The binary is
+    // stored under a key hashed from GL_VENDOR, GL_RENDERER, GL_VERSION and the shader
+    // sources: after a driver update or a shader change the key no longer matches and the
+    // program is compiled again. A binary the driver refuses to link is replaced the same way.
+    class ProgramBinaryCache
+    {
+    public:
+        struct Stats
+        {
+            bool loaded = false;   // linked from the cached binary
+            bool rejected = false; // a cached binary was found but was stale or did not link
+            bool saved = false;    // compiled from source and written to the file
+            int64_t loadTime = 0;  // ns reading the file and linking the binary
+            int64_t buildTime = 0; // ns compiling and linking from source, when loaded: what it took when the binary was made
+
+            int64_t GetTimeSaved() const { return loaded ? buildTime - loadTime : 0; }
+        };
+
+    public:
+        ProgramBinaryCache() = default;
+        ProgramBinaryCache(const ProgramBinaryCache &) = delete;
+        ProgramBinaryCache &operator=(const ProgramBinaryCache &) = delete;
+
+        void SetPath(const std::string &path) { m_path = path; }
+        const std::string &GetPath() const { return m_path; }
+
+        // Hooks the cache into the GL backend of the current ImGui context. Needs
+        // ImGui_ImplOpenGL3_Init() first and has to stay alive until the device objects exist.
+        void Attach();
+
+        const Stats &GetStats() const { return m_stats; }
+
+    private:
+        static bool Load(void *userData, unsigned int program, const char *glslVersion, const char *vertexShader, const char *fragmentShader);
+        static void Save(void *userData, unsigned int program, const char *glslVersion, const char *vertexShader, const char *fragmentShader);
+
+        static uint64_t ComputeKey(const char *glslVersion, const char *vertexShader, const char *fragmentShader);
+
+    private:
+        std::string m_path;
+        Stats m_stats;
+        int64_t m_buildStart = 0;
+    };
+
+} // namespace android
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace android
+{
+    // Chooses a render resolution scale from measured frame costs. The cost is smoothed,
+    // and every kEvaluateFrames frames the scale drops when over budget or creeps back up
+    // when there is headroom. Scales snap to kStep, so buffer sizes rarely change.
+    class ResolutionScaler
+    {
+    public:
+        static constexpr int32_t kEvaluateFrames = 30;
+        static constexpr float kStep = 0.05f;
+        static constexpr float kHeadroom = 0.7f; // scale up only below this fraction of the budget
+
+        void SetBudget(int64_t budget) { m_budget = budget > 0 ? budget : 1; }
+
+        void SetRange(float minScale, float maxScale)
+        {
+            m_minScale = std::clamp(minScale, kStep, 1.0f);
+            m_maxScale = std::clamp(maxScale, m_minScale, 1.0f);
+            m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+        }
+
+        float GetScale() const { return m_scale; }
+        int64_t GetAverageCost() const { return static_cast<int64_t>(m_averageCost); }
+
+        void Reset()
+        {
+            m_scale = m_maxScale;
+            m_averageCost = 0.0;
+            m_frames = 0;
+        }
+
+        // `cost` in ns for the latest frame. Returns true when GetScale() changed.
+        bool Update(int64_t cost)
+        {
+            m_averageCost = m_averageCost <= 0.0 ? static_cast<double>(cost)
+                                                  : m_averageCost + (static_cast<double>(cost) - m_averageCost) * 0.1;
+            if (++m_frames < kEvaluateFrames)
+                return false;
+            m_frames = 0;
+
+            float scale = m_scale;
+            const double budget = static_cast<double>(m_budget);
+            if (m_averageCost > budget)
+            {
+                // Cost is mostly fill rate, so it scales with the pixel count (scale squared).
+                scale = std::min(m_scale - kStep, m_scale * static_cast<float>(std::sqrt(budget / m_averageCost)));
+            }
+            else if (m_averageCost < budget * kHeadroom)
+            {
+                scale = m_scale + kStep;
+            }
+
+            scale = std::clamp(std::round(scale / kStep) * kStep, m_minScale, m_maxScale);
+            if (std::fabs(scale - m_scale) < kStep * 0.5f)
+                return false;
+
+            // Costs measured at the old scale no longer apply.
+            m_scale = scale;
+            m_averageCost = 0.0;
+            return true;
+        }
+
+    private:
+        int64_t m_budget = 8333333;
+        float m_minScale = 0.5f;
+        float m_maxScale = 1.0f;
+        float m_scale = 1.0f;
+        double m_averageCost = 0.0;
+        int32_t m_frames = 0;
+    };
+
+} // namespace android
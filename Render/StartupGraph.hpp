@@ -0,0 +1,226 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+
+#include "FrameScheduler.hpp"
+
+namespace android
+{
+    // Initialization as a dependency graph. A stage starts as soon as all stages it depends
+    // on have succeeded; independent stages run at the same time on their own threads.
+    // Stages pinned to the caller (anything that makes the GL context current) run on the
+    // thread that calls Run(). After a failure no new stage starts, the running ones are
+    // waited for. Start and end of every stage are recorded relative to Run().
+    class StartupGraph
+    {
+    public:
+        using Stage = int32_t;
+
+        static constexpr int32_t kMaxStages = 16;
+        static constexpr int32_t kMaxDependencies = 4;
+
+        struct Timing
+        {
+            const char *name = nullptr;
+            int64_t start = 0; // ns since Run()
+            int64_t end = 0;
+            bool worker = false; // ran on a thread of its own
+            bool ran = false;
+            bool succeeded = false;
+        };
+
+    public:
+        StartupGraph() = default;
+        StartupGraph(const StartupGraph &) = delete;
+        StartupGraph &operator=(const StartupGraph &) = delete;
+
+        // Dependencies have to be added first, so the order of Add() calls is a valid serial order.
+        Stage Add(const char *name, std::function<bool()> function, std::initializer_list<Stage> dependencies = {}, bool onCaller = false)
+        {
+            if (m_count >= kMaxStages || static_cast<int32_t>(dependencies.size()) > kMaxDependencies)
+            {
+                m_invalid = true;
+                return -1;
+            }
+
+            Node &node = m_nodes[m_count];
+            node.function = std::move(function);
+            node.onCaller = onCaller;
+            node.dependencyCount = 0;
+            for (Stage dependency : dependencies)
+            {
+                if (dependency >= 0 && dependency < m_count)
+                    node.dependencies[node.dependencyCount++] = dependency;
+                else
+                    m_invalid = true;
+            }
+
+            m_timings[m_count] = Timing{};
+            m_timings[m_count].name = name;
+            return m_count++;
+        }
+
+        // Runs every stage once, concurrently unless `parallel` is false. Returns false if a stage
+        // failed; nothing runs when a stage or dependency could not be added.
+        bool Run(bool parallel = true)
+        {
+            if (m_invalid)
+                return false;
+
+            m_start = SteadyFrameClock::Instance().Now();
+            bool succeeded = parallel ? RunParallel() : RunSerial();
+            m_elapsed = SteadyFrameClock::Instance().Now() - m_start;
+            return succeeded;
+        }
+
+        int32_t GetStageCount() const { return m_count; }
+        const Timing &GetTiming(Stage stage) const { return m_timings[stage]; }
+        bool Succeeded(Stage stage) const { return stage >= 0 && stage < m_count && m_timings[stage].succeeded; }
+        int64_t GetStartTime() const { return m_start; }
+        int64_t GetElapsed() const { return m_elapsed; }
+
+        // Sum of the stage durations: what a serial run would have taken.
+        int64_t GetSerialTime() const
+        {
+            int64_t total = 0;
+            for (int32_t i = 0; i < m_count; ++i)
+                total += m_timings[i].end - m_timings[i].start;
+            return total;
+        }
+
+    private:
+        enum class State : uint8_t
+        {
+            Waiting,
+            Running,
+            Done,
+            Failed
+        };
+
+        struct Node
+        {
+            std::function<bool()> function;
+            Stage dependencies[kMaxDependencies] = {};
+            int32_t dependencyCount = 0;
+            bool onCaller = false;
+            State state = State::Waiting;
+            std::thread thread;
+        };
+
+        bool IsReady(const Node &node) const
+        {
+            if (State::Waiting != node.state)
+                return false;
+            for (int32_t i = 0; i < node.dependencyCount; ++i)
+                if (State::Done != m_nodes[node.dependencies[i]].state)
+                    return false;
+            return true;
+        }
+
+        bool Execute(Stage stage)
+        {
+            Timing &timing = m_timings[stage];
+            timing.start = SteadyFrameClock::Instance().Now() - m_start;
+            timing.succeeded = m_nodes[stage].function();
+            timing.end = SteadyFrameClock::Instance().Now() - m_start;
+            timing.ran = true;
+            return timing.succeeded;
+        }
+
+        bool RunSerial()
+        {
+            for (Stage stage = 0; stage < m_count; ++stage)
+            {
+                m_nodes[stage].state = Execute(stage) ? State::Done : State::Failed;
+                if (State::Failed == m_nodes[stage].state)
+                    return false;
+            }
+            return true;
+        }
+
+        bool RunParallel()
+        {
+            std::unique_lock lock(m_mutex);
+            bool failed = false;
+
+            for (;;)
+            {
+                for (Stage stage = 0; stage < m_count; ++stage)
+                    failed |= State::Failed == m_nodes[stage].state;
+
+                Stage callerStage = -1;
+                if (!failed)
+                {
+                    for (Stage stage = 0; stage < m_count; ++stage)
+                    {
+                        Node &node = m_nodes[stage];
+                        if (!IsReady(node))
+                            continue;
+
+                        if (node.onCaller)
+                        {
+                            if (callerStage < 0)
+                                callerStage = stage;
+                            continue;
+                        }
+
+                        node.state = State::Running;
+                        m_timings[stage].worker = true;
+                        node.thread = std::thread([this, stage]
+                                                  {
+                                                      bool succeeded = Execute(stage);
+                                                      std::lock_guard guard(m_mutex);
+                                                      m_nodes[stage].state = succeeded ? State::Done : State::Failed;
+                                                      m_changed.notify_one();
+                                                  });
+                    }
+                }
+
+                if (callerStage >= 0)
+                {
+                    m_nodes[callerStage].state = State::Running;
+                    lock.unlock();
+                    bool succeeded = Execute(callerStage);
+                    lock.lock();
+                    m_nodes[callerStage].state = succeeded ? State::Done : State::Failed;
+                    continue;
+                }
+
+                // Nothing can start here: done, or a worker has to finish first.
+                int32_t running = 0;
+                for (Stage stage = 0; stage < m_count; ++stage)
+                    running += State::Running == m_nodes[stage].state;
+                if (0 == running)
+                    break;
+                m_changed.wait(lock);
+            }
+
+            lock.unlock();
+            bool succeeded = !failed;
+            for (Stage stage = 0; stage < m_count; ++stage)
+            {
+                if (m_nodes[stage].thread.joinable())
+                    m_nodes[stage].thread.join();
+                succeeded &= State::Done == m_nodes[stage].state;
+            }
+            return succeeded;
+        }
+
+    private:
+        Node m_nodes[kMaxStages];
+        Timing m_timings[kMaxStages];
+        int32_t m_count = 0;
+        int64_t m_start = 0;
+        int64_t m_elapsed = 0;
+        bool m_invalid = false;
+
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+    };
+
+} // namespace android
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace android
+{
+    // Picks the overlay surface rect for the current UI bounds, in display pixels.
+    // Growing happens at once so nothing gets clipped, with some slack so a window being
+    // dragged does not resize the surface every frame. Shrinking waits until the UI used
+    // less than half of the surface for kShrinkFrames frames in a row.
+    class SurfaceFitter
+    {
+    public:
+        struct Rect
+        {
+            int32_t x = 0;
+            int32_t y = 0;
+            int32_t width = 0;
+            int32_t height = 0;
+
+            bool operator==(const Rect &other) const
+            {
+                return x == other.x && y == other.y && width == other.width && height == other.height;
+            }
+        };
+
+        static constexpr int32_t kAlignment = 64; // rect edges snap to this grid
+        static constexpr int32_t kSlack = 64;     // room kept around the content when fitting
+        static constexpr int32_t kShrinkFrames = 60;
+
+        // Starts over covering the whole display.
+        void SetDisplaySize(int32_t width, int32_t height)
+        {
+            m_displayWidth = width;
+            m_displayHeight = height;
+            m_rect = Rect{0, 0, width, height};
+            m_shrinkFrames = 0;
+        }
+
+        const Rect &GetRect() const { return m_rect; }
+
+        // `content` is (x1, y1, x2, y2) like ImDrawCmd::ClipRect. Returns true when GetRect() changed.
+        bool Update(const ImVec4 &content)
+        {
+            bool empty = content.z <= content.x || content.w <= content.y;
+            Rect fit = empty ? Rect{0, 0, kAlignment, kAlignment} : Fit(content);
+
+            bool contained = empty ||
+                             (content.x >= m_rect.x && content.y >= m_rect.y &&
+                              content.z <= m_rect.x + m_rect.width && content.w <= m_rect.y + m_rect.height);
+            if (!contained)
+            {
+                m_shrinkFrames = 0;
+                return Assign(fit);
+            }
+
+            if (2 * Area(fit) >= Area(m_rect))
+            {
+                m_shrinkFrames = 0;
+                return false;
+            }
+
+            if (++m_shrinkFrames < kShrinkFrames)
+                return false;
+
+            m_shrinkFrames = 0;
+            return Assign(fit);
+        }
+
+    private:
+        Rect Fit(const ImVec4 &content) const
+        {
+            auto snapDown = [](float value)
+            { return static_cast<int32_t>(floorf((value - kSlack) / kAlignment)) * kAlignment; };
+            auto snapUp = [](float value)
+            { return static_cast<int32_t>(ceilf((value + kSlack) / kAlignment)) * kAlignment; };
+
+            int32_t x1 = std::max(snapDown(content.x), 0);
+            int32_t y1 = std::max(snapDown(content.y), 0);
+            int32_t x2 = std::min(snapUp(content.z), m_displayWidth);
+            int32_t y2 = std::min(snapUp(content.w), m_displayHeight);
+            return Rect{x1, y1, std::max(x2 - x1, 1), std::max(y2 - y1, 1)};
+        }
+
+        bool Assign(const Rect &rect)
+        {
+            if (rect == m_rect)
+                return false;
+            m_rect = rect;
+            return true;
+        }
+
+        static int64_t Area(const Rect &rect) { return static_cast<int64_t>(rect.width) * rect.height; }
+
+    private:
+        int32_t m_displayWidth = 0;
+        int32_t m_displayHeight = 0;
+        Rect m_rect;
+        int32_t m_shrinkFrames = 0;
+    };
+
+} // namespace android
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace android
+{
+    // Lock-free single-producer/single-consumer handoff of the latest value.
+    // The producer fills Back() and publishes it; the consumer acquires the most
+    // recently published slot as Front(). The third slot sits in the middle so
+    // neither side ever waits for the other. A published value that is replaced
+    // before the consumer picks it up is dropped.
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        // Producer: slot to fill before Publish().
+        T &Back() { return m_slots[m_back]; }
+
+        // Producer: makes Back() visible to the consumer. Returns false when the
+        // previously published value was never acquired and got dropped.
+        bool Publish()
+        {
+            uint32_t previous = m_middle.load(std::memory_order_relaxed);
+            while (!m_middle.compare_exchange_weak(previous, m_back | kFresh | (previous & kStopped),
+                                                   std::memory_order_acq_rel, std::memory_order_relaxed))
+                ;
+            m_back = previous & kIndexMask;
+            m_middle.notify_one();
+            return 0 == (previous & kFresh);
+        }
+
+        // Consumer: slot acquired by the last successful Acquire().
+        T &Front() { return m_slots[m_front]; }
+
+        // Consumer: swaps in the latest published value, if there is a new one.
+        bool Acquire()
+        {
+            uint32_t previous = m_middle.load(std::memory_order_relaxed);
+            do
+            {
+                if (0 == (previous & kFresh))
+                    return false;
+            } while (!m_middle.compare_exchange_weak(previous, m_front | (previous & kStopped),
+                                                     std::memory_order_acq_rel, std::memory_order_relaxed));
+            m_front = previous & kIndexMask;
+            return true;
+        }
+
+        // Consumer: blocks until a value is published or Stop() is called.
+        // Returns false once stopped.
+        bool Wait()
+        {
+            uint32_t middle = m_middle.load(std::memory_order_acquire);
+            while (0 == (middle & (kFresh | kStopped)))
+            {
+                m_middle.wait(middle, std::memory_order_acquire);
+                middle = m_middle.load(std::memory_order_acquire);
+            }
+            return 0 == (middle & kStopped);
+        }
+
+        void Stop()
+        {
+            m_middle.fetch_or(kStopped, std::memory_order_acq_rel);
+            m_middle.notify_all();
+        }
+
+        void Reset()
+        {
+            m_middle.store(1, std::memory_order_relaxed);
+            m_back = 0;
+            m_front = 2;
+        }
+
+    private:
+        static constexpr uint32_t kIndexMask = 0x3;
+        static constexpr uint32_t kFresh = 0x4;
+        static constexpr uint32_t kStopped = 0x8;
+
+        T m_slots[3];
+        std::atomic<uint32_t> m_middle{1};
+        uint32_t m_back = 0;
+        uint32_t m_front = 2;
+    };
+
+} // namespace android